@@ -0,0 +1,307 @@
+#include "app_controller.h"
+#include "control_protocol.h"
+
+AppController::AppController(Host& host, TimerWheel& timers, Clock& clock, TraceRing& trace)
+    : host_(host), timers_(timers), clock_(clock), trace_(trace) {}
+
+AppController::~AppController() {
+    timers_.Cancel(mouse_timer_);
+    timers_.Cancel(resume_timer_);
+    timers_.Cancel(schedule_timer_);
+}
+
+ParseResult AppController::Load(const std::string& cmd_line, std::string& error) {
+    cmd_line_ = cmd_line;
+    Config config;
+    ParseResult result = BuildConfig(config_overrides_, config, error);
+    if (result == ParseResult::kOk) {
+        base_config_ = config;
+        config_store_.Publish(config);
+    }
+    return result;
+}
+
+void AppController::Start(MouseEngine& engine, std::unique_ptr<PowerRequest> power_request) {
+    engine_ = &engine;
+    power_request_ = std::move(power_request);
+    if (power_request_) {
+        power_request_->SetFailedCallback(&AppController::OnPowerRequestFailed, this);
+    }
+    stats_.start_time = clock_.Now();
+    UpdateEffectiveConfig(0);
+}
+
+void AppController::Stop() {
+    // Nothing may stay held or armed once the host's OS objects are gone
+    if (keeping_awake_) {
+        keeping_awake_ = false;
+        StopKeepAwake();
+    }
+    power_request_.reset();
+    timers_.Cancel(resume_timer_);
+    timers_.Cancel(schedule_timer_);
+}
+
+ParseResult AppController::BuildConfig(const std::string& overrides, Config& config, std::string& error) const {
+    ParseResult result = LoadConfiguration(cmd_line_ + ' ' + overrides, config, error);
+    if (result != ParseResult::kOk) {
+        return result;
+    }
+    host_.ApplyPolicy(config);
+    return ValidateConfig(config, error) ? ParseResult::kOk : ParseResult::kError;
+}
+
+void AppController::ReloadConfig() {
+    std::string error;
+    if (!ApplyConfig(config_overrides_, error)) {
+        host_.Report("config not reloaded: " + error);
+    }
+}
+
+bool AppController::ApplyConfig(const std::string& overrides, std::string& error) {
+    Config config;
+    switch (BuildConfig(overrides, config, error)) {
+        case ParseResult::kHelp:
+            error = "-h/--help is not allowed here";
+            return false;
+        case ParseResult::kError:
+            return false;
+        case ParseResult::kOk:
+            break;
+    }
+    
+    // These pick their mechanism at startup and keep it
+    const Config& current = config_store_.Current();
+    config.power_mode = current.power_mode;
+    config.input_hooks = current.input_hooks;
+    config.efficiency = current.efficiency;
+    base_config_ = config;
+    UpdateEffectiveConfig(0);
+    return true;
+}
+
+void AppController::UpdateEffectiveConfig(uint64_t early_by) {
+    // A slack wakeup counts as the transition it was armed for, rather than
+    // waking again for the rest of the wait
+    auto now = host_.WallNow() + std::chrono::milliseconds(early_by);
+    Schedule::State state = base_config_.schedule.Evaluate(now);
+    Config& config = effective_config_;
+    EffectiveConfig(base_config_, state.interval, host_.CurrentPowerSource(), config);
+    config_store_.Publish(config);
+    RecordTrace(TraceEvent::kConfig);
+    host_.SetTimerSlack(config.slack_percent);
+    
+    // Off hours cost one timer for the next start and nothing else
+    if (state.next_change_ms) {
+        timers_.Schedule(schedule_timer_, clock_.Now() + early_by + state.next_change_ms);
+    } else {
+        timers_.Cancel(schedule_timer_);
+    }
+    schedule_active_ = state.active;
+    UpdateKeepAwake();
+    
+    // Wake the scheduler so new intervals apply now, not after the old wait
+    if (mouse_timer_.IsArmed()) {
+        timers_.Schedule(mouse_timer_, clock_.Now());
+    }
+    host_.OnStateChanged();
+    PublishStatus();
+}
+
+void AppController::OnScheduleTimer(void* context) {
+    auto* controller = static_cast<AppController*>(context);
+    uint64_t now = controller->clock_.Now();
+    uint64_t due = controller->schedule_timer_.Expiry();
+    controller->UpdateEffectiveConfig(due > now ? due - now : 0);
+}
+
+void AppController::SetPaused(bool paused) {
+    // Any explicit change ends a timed pause
+    timers_.Cancel(resume_timer_);
+    if (paused == is_paused_) {
+        return;
+    }
+    is_paused_ = paused;
+    uint64_t now = clock_.Now();
+    
+    RecordTrace(is_paused_ ? TraceEvent::kPaused : TraceEvent::kResumed);
+    if (is_paused_) {
+        paused_since_ = now;
+    } else {
+        stats_.RecordResume(now - paused_since_, static_cast<uint64_t>(config_store_.Current().short_delay) * 1000);
+    }
+    UpdateKeepAwake();
+    host_.OnStateChanged();
+    PublishStatus();
+}
+
+void AppController::OnResumeTimer(void* context) {
+    static_cast<AppController*>(context)->SetPaused(false);
+}
+
+void AppController::OnSessionChanged() {
+    // A lock despite our moves is what --calibrate learns from
+    if (keeping_awake_ && !power_request_ && host_.IsSessionLocked() && engine_->OnSessionLocked(clock_.Now())) {
+        host_.OnCalibrated(engine_->Calibration().Record());
+    }
+    // Lockers that ignore the request (GNOME and KDE with the logind
+    // inhibitor) lock all the same: it does nothing here
+    if (keeping_awake_ && power_request_ && host_.IsSessionLocked()) {
+        DropPowerRequest("the power request did not keep the session unlocked");
+    }
+    RecordTrace(host_.IsSessionActive() ? TraceEvent::kBack : TraceEvent::kAway);
+    UpdateKeepAwake();
+    host_.OnStateChanged();
+    PublishStatus();
+}
+
+uint64_t AppController::State() const {
+    return is_paused_ ? StatusSnapshot::kPaused
+         : !schedule_active_ ? StatusSnapshot::kOffSchedule
+         : !host_.IsSessionActive() ? StatusSnapshot::kAway
+         : power_request_ ? StatusSnapshot::kPowerRequest : StatusSnapshot::kRunning;
+}
+
+void AppController::PublishStatus() {
+    const Config& config = config_store_.Current();
+    StatusSnapshot status;
+    status.state = State();
+    status.short_delay = static_cast<uint64_t>(config.short_delay);
+    status.long_delay = static_cast<uint64_t>(config.long_delay);
+    status.distance = static_cast<uint64_t>(config.distance);
+    status.start_time = stats_.start_time;
+    status.last_move_time = engine_->LastMove();
+    status.last_input_time = engine_->LastUserInput();
+    status.next_wake_time = mouse_timer_.IsArmed() ? mouse_timer_.Expiry()
+                          : schedule_timer_.IsArmed() ? schedule_timer_.Expiry() : 0;
+    status.resume_time = resume_timer_.IsArmed() ? resume_timer_.Expiry() : 0;
+    host_.PublishStatus(status, stats_, clock_.Now());
+}
+
+std::string AppController::HandleControlRequest(const std::string& text) {
+    ControlRequest request;
+    std::string error;
+    if (!ParseControlRequest(text, request, error)) {
+        return "error " + error;
+    }
+    
+    uint64_t now = clock_.Now();
+    switch (request.command) {
+        case ControlCommand::kPause:
+            SetPaused(true);
+            if (request.pause_minutes) {
+                timers_.Schedule(resume_timer_, now + static_cast<uint64_t>(request.pause_minutes) * 60000);
+            }
+            break;
+        case ControlCommand::kResume:
+            SetPaused(false);
+            break;
+        case ControlCommand::kNudge:
+            engine_->Nudge(now);
+            break;
+        case ControlCommand::kStatus: {
+            uint64_t resume_at = resume_timer_.IsArmed() ? resume_timer_.Expiry() : now;
+            uint64_t change_at = schedule_timer_.IsArmed() ? schedule_timer_.Expiry() : now;
+            return FormatStatusReply(State(), resume_at > now ? resume_at - now : 0,
+                                     change_at > now ? change_at - now : 0, host_.CurrentPowerSource(),
+                                     power_request_ != nullptr, config_store_.Current(), stats_);
+        }
+        case ControlCommand::kTrace:
+            if (!trace_.Dump(request.path, error)) {
+                return "error " + error;
+            }
+            break;
+        case ControlCommand::kSet: {
+            // Kept on success, so later file reloads apply on top of it
+            std::string overrides = config_overrides_ + ' ' + request.options;
+            if (!ApplyConfig(overrides, error)) {
+                return "error " + error;
+            }
+            config_overrides_ = overrides;
+            break;
+        }
+    }
+    PublishStatus();
+    return "ok";
+}
+
+void AppController::UpdateKeepAwake() {
+    // Kept awake unless paused, outside the schedule or with nobody at
+    // the session; parked, nothing is scheduled and nothing is injected
+    bool awake = !is_paused_ && schedule_active_ && host_.IsSessionActive();
+    if (awake == keeping_awake_) {
+        return;
+    }
+    keeping_awake_ = awake;
+    if (awake) {
+        StartKeepAwake();
+    } else {
+        StopKeepAwake();
+    }
+}
+
+void AppController::StartKeepAwake() {
+    if (power_request_) {
+        std::string error;
+        if (power_request_->Acquire(error)) {
+            host_.OnPowerRequest(true);
+            return;
+        }
+        FallBackToMoving(error);
+        return;
+    }
+    
+    // Movement ticks immediately, then reschedules itself
+    timers_.Schedule(mouse_timer_, clock_.Now());
+}
+
+void AppController::FallBackToMoving(const std::string& reason) {
+    // Not effective here: fall back to the movement engine for good
+    host_.Report(reason + ", moving the mouse instead");
+    power_request_.reset();
+    if (keeping_awake_) {
+        timers_.Schedule(mouse_timer_, clock_.Now());
+    }
+}
+
+void AppController::DropPowerRequest(const std::string& reason) {
+    power_request_->Release();
+    host_.OnPowerRequest(false);
+    FallBackToMoving(reason);
+}
+
+void AppController::OnPowerRequestFailed(void* context, const std::string& error) {
+    // Runs from inside the request, which is gone afterwards
+    auto* controller = static_cast<AppController*>(context);
+    controller->DropPowerRequest(error);
+    controller->host_.OnStateChanged();
+    controller->PublishStatus();
+}
+
+void AppController::StopKeepAwake() {
+    if (power_request_) {
+        power_request_->Release();
+        host_.OnPowerRequest(false);
+    }
+    timers_.Cancel(mouse_timer_);
+}
+
+void AppController::RecordTrace(TraceEvent event) {
+    TraceRecord record = {};
+    record.time = clock_.Now();
+    record.config_version = static_cast<uint32_t>(config_store_.Version());
+    record.event = static_cast<uint8_t>(event);
+    trace_.Record(record);
+}
+
+void AppController::OnMouseTimer(void* context) {
+    auto* controller = static_cast<AppController*>(context);
+    uint64_t now = controller->clock_.Now();
+    uint64_t due = controller->mouse_timer_.Expiry();
+    
+    controller->stats_.RecordWakeup(now, due);
+    uint64_t next_tick = controller->engine_->Tick(now, due > now ? due - now : 0);
+    controller->timers_.Schedule(controller->mouse_timer_, next_tick);
+    controller->PublishStatus();
+    controller->host_.OnTicked();
+}
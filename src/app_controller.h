@@ -0,0 +1,145 @@
+#pragma once
+
+#include "calibration.h"
+#include "clock.h"
+#include "config.h"
+#include "config_store.h"
+#include "mouse_engine.h"
+#include "power_request.h"
+#include "stats.h"
+#include "status_page.h"
+#include "timer_wheel.h"
+#include "trace.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// What the Windows and the Linux front end have in common: the effective
+// configuration (schedule window and power profile), pausing, keeping
+// awake by power request or by moving, the control requests and the
+// status page. Runs on the reactor thread. The front ends own the OS side
+// (window or display connection, monitors, watchers, endpoints) and
+// connect it through Host.
+class AppController {
+public:
+    class Host {
+    public:
+        virtual ~Host() = default;
+        
+        // As the session and power source monitors see it
+        virtual bool IsSessionActive() const = 0;
+        virtual bool IsSessionLocked() const = 0;
+        virtual PowerSource CurrentPowerSource() const = 0;
+        
+        // Wall time the schedule windows are evaluated at
+        virtual std::chrono::system_clock::time_point WallNow() { return std::chrono::system_clock::now(); }
+        
+        // Settings that win over the command line and the file (Windows policy)
+        virtual void ApplyPolicy(Config&) const {}
+        
+        virtual void SetTimerSlack(int percent) = 0;
+        
+        // Fills in the pid and writes the status page
+        virtual void PublishStatus(StatusSnapshot& status, const Stats& stats, uint64_t now) = 0;
+        
+        // The power request was taken (true) or released
+        virtual void OnPowerRequest(bool) {}
+        
+        // Pause, schedule window, session or configuration changed
+        virtual void OnStateChanged() {}
+        
+        // After each mouse tick, with the next one armed
+        virtual void OnTicked() {}
+        
+        // Calibration learned a new lock timeout, to be stored
+        virtual void OnCalibrated(const CalibrationRecord& record) = 0;
+        
+        // A problem the app runs on with, one line without a prefix
+        virtual void Report(const std::string& message) = 0;
+    };
+    
+    AppController(Host& host, TimerWheel& timers, Clock& clock, TraceRing& trace);
+    ~AppController();
+    AppController(const AppController&) = delete;
+    AppController& operator=(const AppController&) = delete;
+    
+    // Builds the configuration from the command line, the file and policy
+    // and publishes it
+    ParseResult Load(const std::string& cmd_line, std::string& error);
+    
+    // Starts keeping awake: moving with `engine`, or holding `power_request`
+    // when --power is in effect and the OS grants it. A request refused
+    // later, or one the session locks through, falls back to moving.
+    void Start(MouseEngine& engine, std::unique_ptr<PowerRequest> power_request);
+    bool IsStarted() const { return engine_ != nullptr; }
+    
+    // Releases the power request and stops all timers, before the host's
+    // OS objects go away
+    void Stop();
+    
+    // The file or policy changed; a broken edit keeps the running configuration
+    void ReloadConfig();
+    
+    // The power source or the wall clock changed
+    void UpdateEffectiveConfig() { UpdateEffectiveConfig(0); }
+    
+    void TogglePause() { SetPaused(!is_paused_); }
+    void SetPaused(bool paused);
+    
+    // The session monitor's callback
+    void OnSessionChanged();
+    
+    // One --ctl request; returns the reply
+    std::string HandleControlRequest(const std::string& text);
+    
+    const ConfigStore& Configs() const { return config_store_; }
+    const Config& Current() const { return config_store_.Current(); }
+    Stats& Statistics() { return stats_; }
+    const Stats& Statistics() const { return stats_; }
+    
+    bool IsPaused() const { return is_paused_; }
+    bool IsScheduleActive() const { return schedule_active_; }
+    bool HasPowerRequest() const { return power_request_ != nullptr; }
+    
+    // StatusSnapshot::State
+    uint64_t State() const;
+    
+private:
+    ParseResult BuildConfig(const std::string& overrides, Config& config, std::string& error) const;
+    bool ApplyConfig(const std::string& overrides, std::string& error);
+    void UpdateEffectiveConfig(uint64_t early_by);
+    void UpdateKeepAwake();
+    void StartKeepAwake();
+    void StopKeepAwake();
+    void FallBackToMoving(const std::string& reason);
+    void DropPowerRequest(const std::string& reason);
+    static void OnPowerRequestFailed(void* context, const std::string& error);
+    void PublishStatus();
+    void RecordTrace(TraceEvent event);
+    static void OnMouseTimer(void* context);
+    static void OnResumeTimer(void* context);
+    static void OnScheduleTimer(void* context);
+    
+    Host& host_;
+    TimerWheel& timers_;
+    Clock& clock_;
+    TraceRing& trace_;
+    MouseEngine* engine_ = nullptr;
+    std::unique_ptr<PowerRequest> power_request_;   // null unless --power is in effect
+    
+    std::string cmd_line_;
+    std::string config_overrides_;      // options applied through "set", after the command line
+    ConfigStore config_store_;
+    Config base_config_;                // as configured; config_store_ has the schedule window's overrides applied
+    Config effective_config_;           // scratch for the next publish, reused so transitions do not allocate
+    Stats stats_;
+    bool is_paused_ = false;
+    uint64_t paused_since_ = 0;
+    bool schedule_active_ = true;
+    bool keeping_awake_ = false;
+    
+    TimerWheel::Timer mouse_timer_{&AppController::OnMouseTimer, this};
+    TimerWheel::Timer resume_timer_{&AppController::OnResumeTimer, this};
+    TimerWheel::Timer schedule_timer_{&AppController::OnScheduleTimer, this};
+};
@@ -0,0 +1,30 @@
+#include "calibration.h"
+
+void Calibrator::Load(const CalibrationRecord& record) {
+    record_ = record;
+    probe_ms_ = record_.timeout_seconds ? 0 : kFirstProbeMs;
+}
+
+void Calibrator::OnSurvived(std::time_t now) {
+    if (probe_ms_) {
+        // Nothing up to the cap is as good as no timeout at all
+        probe_ms_ = probe_ms_ * 2 < kMaxProbeMs ? probe_ms_ * 2 : kMaxProbeMs;
+        return;
+    }
+    
+    // Re-validate from time to time: the threshold may have been raised
+    if (now - record_.measured_at >= kReprobeSeconds) {
+        uint64_t learned = static_cast<uint64_t>(record_.timeout_seconds) * 1000;
+        probe_ms_ = learned + learned / 2 < kMaxProbeMs ? learned + learned / 2 : kMaxProbeMs;
+    }
+}
+
+bool Calibrator::OnLocked(uint64_t idle_ms, std::time_t now) {
+    if (idle_ms < kMinLockIdleMs) {
+        return false;
+    }
+    probe_ms_ = 0;
+    record_.timeout_seconds = static_cast<uint32_t>(idle_ms / 1000);
+    record_.measured_at = now;
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+// What calibration has learned, kept across restarts
+struct CalibrationRecord {
+    uint32_t timeout_seconds = 0;   // 0 until a lock has been observed
+    int64_t measured_at = 0;        // wall clock (time_t) of that observation
+};
+
+// Calibration (--calibrate) for machines whose lock timeout cannot be
+// read, e.g. because a third-party agent enforces it.
+//
+// Without a learned value it probes: auto mode plans against an assumed
+// timeout that doubles every time a move goes through without a lock.
+// The first lock that follows at least kMinLockIdleMs of idle time gives
+// the threshold itself, since it fires exactly that long after the last
+// input. Shorter idle times mean a manual lock and are ignored. A lock at
+// any later point replaces the learned value. After kReprobeSeconds the
+// learned value is probed past once, so a raised threshold is found too.
+class Calibrator {
+public:
+    static constexpr uint64_t kFirstProbeMs = 2 * 60000;
+    static constexpr uint64_t kMaxProbeMs = 4 * 3600000;
+    static constexpr uint64_t kMinLockIdleMs = 60000;
+    static constexpr int64_t kReprobeSeconds = 30 * 86400;
+    
+    void Load(const CalibrationRecord& record);
+    const CalibrationRecord& Record() const { return record_; }
+    
+    // Timeout to plan against: the learned one, or the current probe
+    uint64_t Timeout() const { return probe_ms_ ? probe_ms_ : static_cast<uint64_t>(record_.timeout_seconds) * 1000; }
+    bool IsProbing() const { return probe_ms_ != 0; }
+    
+    // A move planned against Timeout() went through with the session
+    // still unlocked
+    void OnSurvived(std::time_t now);
+    
+    // The session locked `idle_ms` after the last input while we kept it
+    // awake; returns true if that taught us a new timeout
+    bool OnLocked(uint64_t idle_ms, std::time_t now);
+    
+private:
+    CalibrationRecord record_;
+    uint64_t probe_ms_ = kFirstProbeMs;
+};
+
+// Persistence, per user: HKCU\Software\MouseMover on Windows,
+// $XDG_STATE_HOME/mm/calibration on Linux. A missing record loads as an
+// empty one.
+CalibrationRecord LoadCalibration();
+bool SaveCalibration(const CalibrationRecord& record, std::string& error);
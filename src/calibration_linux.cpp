@@ -0,0 +1,73 @@
+#include "calibration.h"
+#include <sys/stat.h>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+// $XDG_STATE_HOME/mm, else ~/.local/state/mm; empty without either
+std::string StateDirectory() {
+    const char* state_home = std::getenv("XDG_STATE_HOME");
+    if (state_home && *state_home) {
+        return std::string(state_home) + "/mm";
+    }
+    const char* home = std::getenv("HOME");
+    return home ? std::string(home) + "/.local/state/mm" : std::string();
+}
+
+// mkdir -p
+bool MakeDirectories(const std::string& path) {
+    for (std::string::size_type slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+        std::string prefix = path.substr(0, slash);
+        if (mkdir(prefix.c_str(), 0700) != 0 && errno != EEXIST) {
+            return false;
+        }
+        if (slash == std::string::npos) {
+            return true;
+        }
+    }
+}
+}
+
+CalibrationRecord LoadCalibration() {
+    CalibrationRecord record;
+    std::string directory = StateDirectory();
+    FILE* file = directory.empty() ? nullptr : std::fopen((directory + "/calibration").c_str(), "r");
+    if (!file) {
+        return record;
+    }
+    
+    unsigned timeout = 0;
+    int64_t measured = 0;
+    if (std::fscanf(file, "timeout=%u measured=%" SCNd64, &timeout, &measured) == 2) {
+        record.timeout_seconds = timeout;
+        record.measured_at = measured;
+    }
+    std::fclose(file);
+    return record;
+}
+
+bool SaveCalibration(const CalibrationRecord& record, std::string& error) {
+    std::string directory = StateDirectory();
+    if (directory.empty() || !MakeDirectories(directory)) {
+        error = "no state directory for the calibration";
+        return false;
+    }
+    
+    // Written aside and renamed, so a crash never leaves half a record
+    std::string path = directory + "/calibration";
+    std::string temporary = path + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "w");
+    if (!file) {
+        error = "cannot write " + temporary + ": " + std::strerror(errno);
+        return false;
+    }
+    std::fprintf(file, "timeout=%u measured=%" PRId64 "\n", record.timeout_seconds, record.measured_at);
+    if (std::fclose(file) != 0 || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        error = "cannot write " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,45 @@
+#include "calibration.h"
+#include <windows.h>
+
+namespace {
+constexpr const wchar_t* kStateKey = L"SOFTWARE\\MouseMover";
+}
+
+CalibrationRecord LoadCalibration() {
+    CalibrationRecord record;
+    DWORD timeout = 0;
+    DWORD timeout_size = sizeof(timeout);
+    ULONGLONG measured = 0;
+    DWORD measured_size = sizeof(measured);
+    if (RegGetValueW(HKEY_CURRENT_USER, kStateKey, L"LockTimeout", RRF_RT_REG_DWORD, nullptr,
+                     &timeout, &timeout_size) == ERROR_SUCCESS &&
+        RegGetValueW(HKEY_CURRENT_USER, kStateKey, L"LockTimeoutMeasured", RRF_RT_REG_QWORD, nullptr,
+                     &measured, &measured_size) == ERROR_SUCCESS) {
+        record.timeout_seconds = timeout;
+        record.measured_at = static_cast<int64_t>(measured);
+    }
+    return record;
+}
+
+bool SaveCalibration(const CalibrationRecord& record, std::string& error) {
+    HKEY key;
+    LSTATUS status = RegCreateKeyExW(HKEY_CURRENT_USER, kStateKey, 0, nullptr, 0, KEY_SET_VALUE, nullptr, &key, nullptr);
+    if (status != ERROR_SUCCESS) {
+        error = "cannot open HKCU\\Software\\MouseMover (" + std::to_string(status) + ")";
+        return false;
+    }
+    
+    DWORD timeout = record.timeout_seconds;
+    ULONGLONG measured = static_cast<ULONGLONG>(record.measured_at);
+    status = RegSetValueExW(key, L"LockTimeout", 0, REG_DWORD, reinterpret_cast<const BYTE*>(&timeout), sizeof(timeout));
+    if (status == ERROR_SUCCESS) {
+        status = RegSetValueExW(key, L"LockTimeoutMeasured", 0, REG_QWORD, reinterpret_cast<const BYTE*>(&measured),
+                                sizeof(measured));
+    }
+    RegCloseKey(key);
+    if (status != ERROR_SUCCESS) {
+        error = "cannot store the calibration (" + std::to_string(status) + ")";
+        return false;
+    }
+    return true;
+}
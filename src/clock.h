@@ -0,0 +1,24 @@
+#pragma once
+
+#include "reactor.h"
+#include <cstdint>
+#include <ctime>
+
+// Time source of the decision core. Scheduling runs on the monotonic
+// reactor clock, whose readings the caller hands to each MouseEngine call;
+// wall time only dates what calibration learns. The apps use SystemClock,
+// simulations a VirtualClock they advance themselves.
+class Clock {
+public:
+    virtual ~Clock() = default;
+    
+    // Milliseconds on the reactor clock
+    virtual uint64_t Now() = 0;
+    virtual std::time_t WallTime() = 0;
+};
+
+class SystemClock : public Clock {
+public:
+    uint64_t Now() override { return Reactor::Now(); }
+    std::time_t WallTime() override { return std::time(nullptr); }
+};
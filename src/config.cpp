@@ -0,0 +1,370 @@
+#include "config.h"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+bool ParseDelayParameter(const std::string& token, int& target, int min_val, int max_val,
+                         const std::string& param_name, std::string& error) {
+    try {
+        int value = std::stoi(token);
+        if (value < min_val || value > max_val) {
+            error = param_name + " must be between " + std::to_string(min_val) +
+                    " and " + std::to_string(max_val) + " seconds";
+            return false;
+        }
+        target = value;
+        return true;
+    } catch (const std::exception&) {
+        error = "Invalid " + param_name + " parameter";
+        return false;
+    }
+}
+
+bool ParseDistanceParameter(const std::string& token, int& target, std::string& error) {
+    try {
+        int value = std::stoi(token);
+        if (value < kMinDistance || value > kMaxDistance) {
+            error = "Distance must be between 1 and 100 pixels";
+            return false;
+        }
+        target = value;
+        return true;
+    } catch (const std::exception&) {
+        error = "Invalid distance parameter";
+        return false;
+    }
+}
+
+bool ParsePercentParameter(const std::string& token, int& target, int max_val,
+                           const std::string& param_name, std::string& error) {
+    try {
+        int value = std::stoi(token);
+        if (value < 0 || value > max_val) {
+            error = param_name + " must be between 0 and " + std::to_string(max_val) + " percent";
+            return false;
+        }
+        target = value;
+        return true;
+    } catch (const std::exception&) {
+        error = "Invalid " + param_name + " parameter";
+        return false;
+    }
+}
+}
+
+ParseResult ParseCommandLine(const std::string& cmd_line, Config& config, std::string& error) {
+    std::istringstream iss(cmd_line);
+    std::string token;
+    
+    // Check for help first so it wins over parameter errors
+    while (iss >> token) {
+        if (token == "-h" || token == "--help") {
+            return ParseResult::kHelp;
+        }
+    }
+    
+    // Parse parameters
+    iss.clear();
+    iss.str(cmd_line);
+    
+    // --schedule accumulates within one layer but replaces the previous one
+    bool schedule_given = false;
+    
+    while (iss >> token) {
+        if ((token == "-s" || token == "--short-delay") && iss >> token) {
+            if (!ParseDelayParameter(token, config.short_delay, kMinDelaySeconds, kMaxDelaySeconds, "Short-delay", error)) {
+                return ParseResult::kError;
+            }
+        }
+        else if ((token == "-l" || token == "--long-delay") && iss >> token) {
+            if (!ParseDelayParameter(token, config.long_delay, 0, kMaxLongDelaySeconds, "Long-delay", error)) {
+                return ParseResult::kError;
+            }
+        }
+        else if ((token == "-d" || token == "--distance") && iss >> token) {
+            if (!ParseDistanceParameter(token, config.distance, error)) {
+                return ParseResult::kError;
+            }
+        }
+        else if (token == "--slack" && iss >> token) {
+            if (!ParsePercentParameter(token, config.slack_percent, kMaxSlackPercent, "Slack", error)) {
+                return ParseResult::kError;
+            }
+        }
+        else if (token == "--jitter" && iss >> token) {
+            if (!ParsePercentParameter(token, config.jitter_percent, kMaxJitterPercent, "Jitter", error)) {
+                return ParseResult::kError;
+            }
+        }
+        else if (token == "--hooks") {
+            config.input_hooks = true;
+        }
+        else if (token == "--gesture") {
+            config.gesture = true;
+        }
+        else if (token == "--auto") {
+            config.auto_mode = true;
+        }
+        else if (token == "--calibrate") {
+            config.auto_mode = true;
+            config.calibrate = true;
+        }
+        else if (token == "--auto-margin" && iss >> token) {
+            if (!ParseDelayParameter(token, config.auto_margin, kMinAutoMarginSeconds, kMaxAutoMarginSeconds,
+                                     "Auto-margin", error)) {
+                return ParseResult::kError;
+            }
+        }
+        else if (token == "--power") {
+            config.power_mode = true;
+        }
+        else if (token == "--config" && iss >> token) {
+            config.config_path = token;
+        }
+        else if (token == "--trace" && iss >> token) {
+            config.trace_path = token;
+        }
+        else if (token == "--stats") {
+            config.show_stats = true;
+        }
+        else if (token == "--footprint") {
+            config.footprint = true;
+        }
+        else if (token == "--efficiency") {
+            config.efficiency = true;
+        }
+        else if (token == "--start-delay" && iss >> token) {
+            if (!ParseDelayParameter(token, config.start_delay, 0, kMaxStartDelaySeconds, "Start-delay", error)) {
+                return ParseResult::kError;
+            }
+        }
+        else if (token == "--battery" && iss >> token) {
+            config.battery = ConfigProfile();
+            if (token != "none" && !ParseProfile(token, config.battery, error)) {
+                return ParseResult::kError;
+            }
+        }
+        else if (token == "--saver" && iss >> token) {
+            config.saver = ConfigProfile();
+            if (token != "none" && !ParseProfile(token, config.saver, error)) {
+                return ParseResult::kError;
+            }
+        }
+        else if (token == "--schedule" && iss >> token) {
+            if (!schedule_given) {
+                config.schedule.Clear();
+                schedule_given = true;
+            }
+            if (token != "always" && !config.schedule.Add(token, error)) {
+                return ParseResult::kError;
+            }
+        }
+    }
+    
+    return ParseResult::kOk;
+}
+
+bool ValidateConfig(const Config& config, std::string& error) {
+    // Policy values arrive without going through the parser
+    if (config.short_delay < kMinDelaySeconds || config.short_delay > kMaxDelaySeconds ||
+        config.long_delay < 0 || config.long_delay > kMaxLongDelaySeconds) {
+        error = "Delay out of range";
+        return false;
+    }
+    if (config.distance < kMinDistance || config.distance > kMaxDistance) {
+        error = "Distance must be between 1 and 100 pixels";
+        return false;
+    }
+    if (config.slack_percent < 0 || config.slack_percent > kMaxSlackPercent) {
+        error = "Slack must be between 0 and " + std::to_string(kMaxSlackPercent) + " percent";
+        return false;
+    }
+    if (config.jitter_percent < 0 || config.jitter_percent > kMaxJitterPercent) {
+        error = "Jitter must be between 0 and " + std::to_string(kMaxJitterPercent) + " percent";
+        return false;
+    }
+    if (config.auto_margin < kMinAutoMarginSeconds || config.auto_margin > kMaxAutoMarginSeconds) {
+        error = "Auto-margin out of range";
+        return false;
+    }
+    if (config.start_delay < 0 || config.start_delay > kMaxStartDelaySeconds) {
+        error = "Start-delay out of range";
+        return false;
+    }
+    if (config.short_delay > config.long_delay) {
+        error = "Short delay must be less than or equal to long delay";
+        return false;
+    }
+    return true;
+}
+
+void ApplyProfile(Config& applied, const ConfigProfile& profile) {
+    if (profile.short_delay >= 0) {
+        applied.short_delay = profile.short_delay;
+    }
+    if (profile.long_delay >= 0) {
+        applied.long_delay = profile.long_delay;
+    }
+    if (profile.distance >= 0) {
+        applied.distance = profile.distance;
+    }
+    if (profile.slack_percent >= 0) {
+        applied.slack_percent = profile.slack_percent;
+    }
+    if (profile.gesture >= 0) {
+        applied.gesture = profile.gesture != 0;
+    }
+    // A profile may lengthen one delay without the other
+    if (applied.long_delay < applied.short_delay) {
+        applied.long_delay = applied.short_delay;
+    }
+}
+
+void EffectiveConfig(const Config& config, const ScheduleInterval* interval, PowerSource source, Config& effective) {
+    effective = config;
+    if (interval) {
+        ApplyProfile(effective, interval->profile);
+    }
+    if (source != PowerSource::kAc) {
+        ApplyProfile(effective, config.battery);
+    }
+    if (source == PowerSource::kBatterySaver) {
+        ApplyProfile(effective, config.saver);
+    }
+}
+
+std::string DefaultConfigPath() {
+#ifdef _WIN32
+    // Machine-wide, so one file deployment covers every user
+    const char* base = std::getenv("ProgramData");
+    return base ? std::string(base) + "\\MouseMover\\mm.conf" : std::string();
+#else
+    const char* config_home = std::getenv("XDG_CONFIG_HOME");
+    if (config_home && *config_home) {
+        return std::string(config_home) + "/mm/mm.conf";
+    }
+    const char* home = std::getenv("HOME");
+    return home ? std::string(home) + "/.config/mm/mm.conf" : std::string();
+#endif
+}
+
+bool ReadConfigFile(const std::string& path, Config& config, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        return true;
+    }
+    
+    std::string options;
+    std::string line;
+    while (std::getline(file, line)) {
+        options += line.substr(0, line.find('#'));
+        options += ' ';
+    }
+    
+    std::string parse_error;
+    switch (ParseCommandLine(options, config, parse_error)) {
+        case ParseResult::kOk:
+            return true;
+        case ParseResult::kHelp:
+            parse_error = "-h/--help is not allowed here";
+            break;
+        case ParseResult::kError:
+            break;
+    }
+    error = path + ": " + parse_error;
+    return false;
+}
+
+ParseResult LoadConfiguration(const std::string& cmd_line, Config& config, std::string& error) {
+    // The command line goes last but names the file, so it is parsed twice
+    Config command_line;
+    ParseResult result = ParseCommandLine(cmd_line, command_line, error);
+    if (result != ParseResult::kOk) {
+        return result;
+    }
+    
+    Config loaded;
+    std::string path = command_line.config_path.empty() ? DefaultConfigPath() : command_line.config_path;
+    if (!path.empty() && !ReadConfigFile(path, loaded, error)) {
+        return ParseResult::kError;
+    }
+    result = ParseCommandLine(cmd_line, loaded, error);
+    loaded.config_path = path;
+    
+    if (result == ParseResult::kOk) {
+        config = loaded;
+    }
+    return result;
+}
+
+const char* GetHelpText() {
+#ifdef _WIN32
+#define MM_PROGRAM "mm.exe"
+#define MM_RUNNING_NOTES \
+        "The application runs in the system tray.\n" \
+        "Right-click the tray icon for options."
+#define MM_STATS_NOTES "Show runtime statistics in the tray"
+#define MM_CONFIG_PATH "%ProgramData%\\MouseMover\\mm.conf"
+#define MM_PLATFORM_OPTIONS \
+        "      --hooks                 Detect user activity with low-level input hooks\n"
+#else
+#define MM_PROGRAM "mm"
+#define MM_RUNNING_NOTES \
+        "The application runs in the foreground on $DISPLAY.\n" \
+        "Send SIGUSR1 to pause/resume, SIGUSR2 to print statistics,\n" \
+        "SIGINT or SIGTERM to exit."
+#define MM_STATS_NOTES "Print runtime statistics on exit"
+#define MM_CONFIG_PATH "~/.config/mm/mm.conf"
+#define MM_PLATFORM_OPTIONS ""
+#endif
+    return
+        "Mouse Mover v1.0.3 - Prevents screen lock\n\n"
+        "Usage: " MM_PROGRAM " [OPTIONS]\n\n"
+        "Options:\n"
+        "  -s, --short-delay SECONDS   Short delay between moves (default: 5)\n"
+        "  -l, --long-delay SECONDS    Long delay after user activity (default: 30)\n"
+        "  -d, --distance PIXELS       Distance in pixels to move (default: 5)\n"
+        MM_PLATFORM_OPTIONS
+        "      --gesture               Move out and back in one step, cursor does not drift\n"
+        "      --power                 Keep awake with a power request, no mouse movement\n"
+        "      --auto                  Move once per OS screen saver/lock/sleep timeout,\n"
+        "                              just before it would expire\n"
+        "      --auto-margin SECONDS   How long before that timeout to move (default: 60)\n"
+        "      --calibrate             --auto that also learns the lock timeout from\n"
+        "                              session locks when the OS does not report it\n"
+        "      --slack PERCENT         Let the OS batch wakeups within PERCENT of each wait (default: 0)\n"
+        "      --jitter PERCENT        Move up to PERCENT of each interval early, at random, so\n"
+        "                              instances started together do not wake in step (default: 0)\n"
+        "      --config PATH           Config file, reloaded on change (default: " MM_CONFIG_PATH ")\n"
+        "      --stats                 " MM_STATS_NOTES "\n"
+        "      --footprint             Trim memory and lower its priority after startup\n"
+        "      --efficiency            Run at idle priority with EcoQoS, and start the rest\n"
+        "                              at a random point within --start-delay\n"
+        "      --start-delay SECONDS   Spread of the deferred start, at most --long-delay (default: 30)\n"
+        "      --trace PATH            Keep the decision trace in PATH, see mmtrace\n"
+        "      --schedule DAYS@HH:MM-HH:MM[,PROFILE]\n"
+        "                              Only keep awake in this weekly window, optionally\n"
+        "                              with its own PROFILE; repeatable, DAYS as\n"
+        "                              mon-fri, sat+sun or daily (default: always)\n"
+        "      --battery PROFILE       Settings while on battery\n"
+        "      --saver PROFILE         Settings on top of --battery with battery saver on\n"
+        "                              PROFILE: s=N,l=N,d=N,slack=N,gesture=0|1\n"
+        "      --ctl COMMAND           Control the running instance: pause [MINUTES], resume,\n"
+        "                              nudge, status, set OPTIONS, trace PATH\n"
+        "  -h, --help                  Show this help\n\n"
+        "Examples:\n"
+        "  " MM_PROGRAM " -s 3 -l 15 -d 10\n"
+        "  " MM_PROGRAM " --short-delay 2 --long-delay 60\n"
+        "  " MM_PROGRAM " --auto --auto-margin 30\n"
+        "  " MM_PROGRAM " --schedule mon-fri@08:00-18:00 --schedule sat@09:00-13:00,s=30\n"
+        "  " MM_PROGRAM " --battery s=20,l=120,slack=25 --saver s=60,gesture=1\n"
+        "  " MM_PROGRAM " --ctl pause 30\n\n"
+        MM_RUNNING_NOTES;
+#undef MM_PROGRAM
+#undef MM_RUNNING_NOTES
+#undef MM_STATS_NOTES
+#undef MM_CONFIG_PATH
+#undef MM_PLATFORM_OPTIONS
+}
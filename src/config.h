@@ -0,0 +1,77 @@
+#pragma once
+
+#include "profile.h"
+#include "schedule.h"
+#include <string>
+
+// Limits for command line parameters
+constexpr int kMinDelaySeconds = 1;
+constexpr int kMaxDelaySeconds = 3600;
+constexpr int kMaxLongDelaySeconds = 7200;
+constexpr int kMinDistance = 1;
+constexpr int kMaxDistance = 100;
+constexpr int kMaxSlackPercent = 50;
+constexpr int kMaxJitterPercent = 50;
+constexpr int kMinAutoMarginSeconds = 1;
+constexpr int kMaxAutoMarginSeconds = 600;
+constexpr int kMaxStartDelaySeconds = 600;
+
+// What the machine runs on; each source can have its own profile
+enum class PowerSource {
+    kAc,
+    kBattery,
+    kBatterySaver,      // on battery with the OS battery saver on
+};
+
+// Configuration structure
+struct Config {
+    int short_delay = 5;    // seconds between moves
+    int long_delay = 30;    // seconds to wait after user activity
+    int distance = 5;       // pixels to move
+    int slack_percent = 0;  // share of each wait the OS may use to coalesce wakeups
+    int jitter_percent = 0; // share of each interval a move may come early, to desynchronize instances
+    bool input_hooks = false;   // Windows: detect activity with low-level input hooks
+    bool gesture = false;       // move out and back in one injection instead of drifting
+    bool auto_mode = false;     // one move per OS idle timeout instead of every short_delay
+    int auto_margin = 60;       // seconds ahead of the idle timeout the auto move happens
+    bool calibrate = false;     // auto mode: learn the lock timeout from observed locks
+    bool power_mode = false;    // hold an OS power request instead of moving the mouse
+    bool show_stats = false;    // surface the runtime counters (tooltip, menu, dump)
+    bool footprint = false;     // trim memory and lower its priority once started
+    bool efficiency = false;    // EcoQoS and idle priority, rest of startup deferred
+    int start_delay = 30;       // efficiency: startup spread over this many seconds, at most long_delay
+    std::string config_path;    // config file; empty means DefaultConfigPath()
+    std::string trace_path;     // decision trace mapped to this file; empty keeps it in memory
+    Schedule schedule;          // working hours; empty means always
+    ConfigProfile battery;      // applied on battery
+    ConfigProfile saver;        // applied on top of battery with battery saver on
+};
+
+enum class ParseResult {
+    kOk,
+    kHelp,      // -h/--help was given, show GetHelpText()
+    kError,     // error holds a message for the user
+};
+
+// Command line parsing shared by the Windows and Linux front ends
+ParseResult ParseCommandLine(const std::string& cmd_line, Config& config, std::string& error);
+bool ValidateConfig(const Config& config, std::string& error);
+
+// Profile settings on top of config, in place
+void ApplyProfile(Config& config, const ConfigProfile& profile);
+
+// The configuration in effect: the schedule window's profile (null when
+// outside any window or without a schedule), then the power source's.
+// Assigned to `effective`, whose strings and schedule keep their storage,
+// so a transition does not allocate once `effective` has held the config.
+void EffectiveConfig(const Config& config, const ScheduleInterval* interval, PowerSource source, Config& effective);
+const char* GetHelpText();
+
+// Config file: command line options, any number per line, '#' starts a
+// comment. A missing file is not an error.
+std::string DefaultConfigPath();
+bool ReadConfigFile(const std::string& path, Config& config, std::string& error);
+
+// Effective configuration: defaults, then the config file, then the
+// command line. Results are as for ParseCommandLine.
+ParseResult LoadConfiguration(const std::string& cmd_line, Config& config, std::string& error);
@@ -0,0 +1,11 @@
+#include "config_store.h"
+
+ConfigStore::ConfigStore() : current_(&slots_[0]) {
+}
+
+void ConfigStore::Publish(const Config& config) {
+    Config* next = current_.load(std::memory_order_relaxed) == &slots_[0] ? &slots_[1] : &slots_[0];
+    *next = config;
+    current_.store(next, std::memory_order_release);
+    version_.fetch_add(1, std::memory_order_release);
+}
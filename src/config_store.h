@@ -0,0 +1,29 @@
+#pragma once
+
+#include "config.h"
+#include <atomic>
+#include <cstdint>
+
+// Current configuration as an immutable snapshot behind an atomic pointer.
+// Readers take Current() once per operation and use it without locking;
+// Publish() fills the other of two slots and swaps the pointer. A reader
+// therefore must not hold a snapshot across two publishes, which holds for
+// everything on the reactor thread: publishes happen between callbacks.
+class ConfigStore {
+public:
+    ConfigStore();
+    ConfigStore(const ConfigStore&) = delete;
+    ConfigStore& operator=(const ConfigStore&) = delete;
+    
+    const Config& Current() const { return *current_.load(std::memory_order_acquire); }
+    
+    // Bumped on every publish, so readers can tell a snapshot changed
+    uint64_t Version() const { return version_.load(std::memory_order_acquire); }
+    
+    void Publish(const Config& config);
+    
+private:
+    Config slots_[2];
+    std::atomic<const Config*> current_;
+    std::atomic<uint64_t> version_{0};
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "config.h"
+#include "reactor.h"
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Watches the configuration sources through the reactor and calls back on
+// its thread when one changes; nothing polls.
+//
+// Windows: ReadDirectoryChangesW on the config file's directory and
+// RegNotifyChangeKeyValue on HKLM\SOFTWARE\Policies\MouseMover, or on
+// SOFTWARE\Policies until that key exists.
+// Linux: inotify on the config file's directory.
+class ConfigWatcher {
+public:
+    using Callback = void (*)(void* context);
+    
+    ConfigWatcher() = default;
+    ~ConfigWatcher();
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+    
+    // A missing directory or policy key is not an error, it is just not watched
+    bool Start(Reactor& reactor, const std::string& path, Callback callback, void* context);
+    
+#ifdef _WIN32
+    // Applies overrides from HKLM\SOFTWARE\Policies\MouseMover, which win
+    // over the file and the command line
+    static void ApplyPolicy(Config& config);
+#endif
+    
+private:
+    static void OnDirectoryEvent(void* context);
+    
+    Reactor* reactor_ = nullptr;
+    Callback callback_ = nullptr;
+    void* context_ = nullptr;
+    std::string file_name_;
+    
+#ifdef _WIN32
+    static void OnPolicyEvent(void* context);
+    bool ArmDirectoryWatch();
+    bool OpenPolicyKey();
+    bool ArmPolicyWatch();
+    
+    HANDLE directory_ = INVALID_HANDLE_VALUE;
+    HANDLE directory_event_ = nullptr;
+    OVERLAPPED overlapped_ = {};
+    DWORD buffer_[1024];        // FILE_NOTIFY_INFORMATION records, DWORD aligned
+    HKEY policy_key_ = nullptr;
+    bool watching_policies_ = false;    // policy_key_ is SOFTWARE\Policies, ours does not exist yet
+    HANDLE policy_event_ = nullptr;
+#else
+    int inotify_fd_ = -1;
+#endif
+};
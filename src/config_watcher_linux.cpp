@@ -0,0 +1,60 @@
+#include "config_watcher.h"
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cstring>
+
+ConfigWatcher::~ConfigWatcher() {
+    if (inotify_fd_ >= 0) {
+        reactor_->RemoveHandle(inotify_fd_);
+        close(inotify_fd_);
+    }
+}
+
+bool ConfigWatcher::Start(Reactor& reactor, const std::string& path, Callback callback, void* context) {
+    reactor_ = &reactor;
+    callback_ = callback;
+    context_ = context;
+    
+    std::string::size_type separator = path.rfind('/');
+    if (separator == std::string::npos) {
+        return true;
+    }
+    file_name_ = path.substr(separator + 1);
+    
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        return false;
+    }
+    
+    // Watch the directory, since editors replace files rather than rewrite them
+    std::string directory = separator ? path.substr(0, separator) : "/";
+    uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+    if (inotify_add_watch(inotify_fd_, directory.c_str(), mask) < 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+        return true;
+    }
+    return reactor.AddHandle(inotify_fd_, &ConfigWatcher::OnDirectoryEvent, this);
+}
+
+void ConfigWatcher::OnDirectoryEvent(void* context) {
+    auto* watcher = static_cast<ConfigWatcher*>(context);
+    
+    alignas(inotify_event) char buffer[4096];
+    bool changed = false;
+    ssize_t length;
+    while ((length = read(watcher->inotify_fd_, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if ((event->mask & IN_Q_OVERFLOW) ||
+                (event->len && std::strcmp(event->name, watcher->file_name_.c_str()) == 0)) {
+                changed = true;
+            }
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+    }
+    
+    if (changed) {
+        watcher->callback_(watcher->context_);
+    }
+}
@@ -0,0 +1,168 @@
+#include "config_watcher.h"
+
+namespace {
+constexpr const wchar_t* kPoliciesKey = L"SOFTWARE\\Policies";
+constexpr const wchar_t* kPolicyKey = L"SOFTWARE\\Policies\\MouseMover";
+
+std::wstring Utf8ToWide(const std::string& text) {
+    int size = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, nullptr, 0);
+    std::wstring wide(size - 1, 0);
+    MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, &wide[0], size);
+    return wide;
+}
+
+void ReadPolicyValue(const wchar_t* name, int& target) {
+    DWORD value = 0;
+    DWORD size = sizeof(value);
+    if (RegGetValueW(HKEY_LOCAL_MACHINE, kPolicyKey, name, RRF_RT_REG_DWORD, nullptr, &value, &size) == ERROR_SUCCESS) {
+        target = static_cast<int>(value);
+    }
+}
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    if (directory_ != INVALID_HANDLE_VALUE) {
+        reactor_->RemoveHandle(directory_event_);
+        CancelIo(directory_);
+        CloseHandle(directory_);
+    }
+    if (directory_event_) {
+        CloseHandle(directory_event_);
+    }
+    if (policy_key_) {
+        reactor_->RemoveHandle(policy_event_);
+        RegCloseKey(policy_key_);
+    }
+    if (policy_event_) {
+        CloseHandle(policy_event_);
+    }
+}
+
+bool ConfigWatcher::Start(Reactor& reactor, const std::string& path, Callback callback, void* context) {
+    reactor_ = &reactor;
+    callback_ = callback;
+    context_ = context;
+    
+    // Watch the directory, since editors replace files rather than rewrite them
+    std::wstring wide_path = Utf8ToWide(path);
+    size_t separator = wide_path.find_last_of(L"\\/");
+    if (separator != std::wstring::npos) {
+        std::string::size_type name_start = path.find_last_of("\\/") + 1;
+        file_name_ = path.substr(name_start);
+        
+        directory_ = CreateFileW(wide_path.substr(0, separator).c_str(), FILE_LIST_DIRECTORY,
+                                 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                 OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (directory_ != INVALID_HANDLE_VALUE) {
+            directory_event_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+            overlapped_.hEvent = directory_event_;
+            if (!directory_event_ || !ArmDirectoryWatch() ||
+                !reactor.AddHandle(directory_event_, &ConfigWatcher::OnDirectoryEvent, this)) {
+                return false;
+            }
+        }
+    }
+    
+    if (OpenPolicyKey()) {
+        policy_event_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (!policy_event_ || !ArmPolicyWatch() ||
+            !reactor.AddHandle(policy_event_, &ConfigWatcher::OnPolicyEvent, this)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ConfigWatcher::ApplyPolicy(Config& config) {
+    ReadPolicyValue(L"ShortDelay", config.short_delay);
+    ReadPolicyValue(L"LongDelay", config.long_delay);
+    ReadPolicyValue(L"Distance", config.distance);
+    ReadPolicyValue(L"Slack", config.slack_percent);
+    ReadPolicyValue(L"Jitter", config.jitter_percent);
+}
+
+bool ConfigWatcher::ArmDirectoryWatch() {
+    return ReadDirectoryChangesW(directory_, buffer_, sizeof(buffer_), FALSE,
+                                 FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+                                 nullptr, &overlapped_, nullptr) != FALSE;
+}
+
+bool ConfigWatcher::OpenPolicyKey() {
+    // Our own key once it exists; until then Policies, for it to appear.
+    // Querying ours tells when it was deleted.
+    HKEY key = nullptr;
+    watching_policies_ = RegOpenKeyExW(HKEY_LOCAL_MACHINE, kPolicyKey, 0, KEY_NOTIFY | KEY_QUERY_VALUE, &key) !=
+                         ERROR_SUCCESS;
+    if (watching_policies_ && RegOpenKeyExW(HKEY_LOCAL_MACHINE, kPoliciesKey, 0, KEY_NOTIFY, &key) != ERROR_SUCCESS) {
+        return false;
+    }
+    policy_key_ = key;
+    return true;
+}
+
+bool ConfigWatcher::ArmPolicyWatch() {
+    // On Policies only subkeys coming and going, so group policy refreshes
+    // of other products' keys do not reach us
+    DWORD filter = watching_policies_ ? REG_NOTIFY_CHANGE_NAME : REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET;
+    return RegNotifyChangeKeyValue(policy_key_, FALSE, filter, policy_event_, TRUE) == ERROR_SUCCESS;
+}
+
+void ConfigWatcher::OnDirectoryEvent(void* context) {
+    auto* watcher = static_cast<ConfigWatcher*>(context);
+    
+    // Zero bytes means the buffer overflowed; that and a failed read may
+    // both have lost our file's change, so assume it was among them
+    DWORD bytes = 0;
+    bool completed = GetOverlappedResult(watcher->directory_, &watcher->overlapped_, &bytes, FALSE) != FALSE;
+    bool changed = !completed || bytes == 0;
+    std::wstring file_name = Utf8ToWide(watcher->file_name_);
+    const BYTE* record = reinterpret_cast<const BYTE*>(watcher->buffer_);
+    while (!changed && bytes) {
+        const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(record);
+        int length = static_cast<int>(info->FileNameLength / sizeof(wchar_t));
+        changed = CompareStringOrdinal(info->FileName, length, file_name.c_str(),
+                                       static_cast<int>(file_name.size()), TRUE) == CSTR_EQUAL;
+        if (!info->NextEntryOffset) {
+            break;
+        }
+        record += info->NextEntryOffset;
+    }
+    
+    watcher->ArmDirectoryWatch();
+    if (changed) {
+        watcher->callback_(watcher->context_);
+    }
+}
+
+void ConfigWatcher::OnPolicyEvent(void* context) {
+    auto* watcher = static_cast<ConfigWatcher*>(context);
+    
+    // Switch keys when ours appeared or was deleted. Closing the old key
+    // may signal the event, which the new watch must not inherit.
+    bool was_policies = watcher->watching_policies_;
+    HKEY key = nullptr;
+    bool switch_keys = was_policies
+        ? RegOpenKeyExW(HKEY_LOCAL_MACHINE, kPolicyKey, 0, KEY_NOTIFY, &key) == ERROR_SUCCESS
+        : RegQueryInfoKeyW(watcher->policy_key_, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                           nullptr, nullptr, nullptr, nullptr) == ERROR_KEY_DELETED;
+    if (key) {
+        RegCloseKey(key);
+    }
+    if (switch_keys) {
+        RegCloseKey(watcher->policy_key_);
+        watcher->policy_key_ = nullptr;
+        ResetEvent(watcher->policy_event_);
+        if (!watcher->OpenPolicyKey()) {
+            // Policies itself is gone; nothing is left to watch
+            watcher->reactor_->RemoveHandle(watcher->policy_event_);
+            watcher->callback_(watcher->context_);
+            return;
+        }
+    }
+    watcher->ArmPolicyWatch();
+    
+    // Under Policies only our key appearing is a change
+    if (!was_policies || !watcher->watching_policies_) {
+        watcher->callback_(watcher->context_);
+    }
+}
@@ -0,0 +1,103 @@
+#include "control_protocol.h"
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+bool ParseControlRequest(const std::string& text, ControlRequest& request, std::string& error) {
+    std::istringstream iss(text);
+    std::string command;
+    if (!(iss >> command)) {
+        error = "empty request";
+        return false;
+    }
+    
+    std::string argument;
+    if (command == "pause") {
+        request.command = ControlCommand::kPause;
+        request.pause_minutes = 0;
+        if (iss >> argument) {
+            try {
+                request.pause_minutes = std::stoi(argument);
+            } catch (const std::exception&) {
+                request.pause_minutes = -1;
+            }
+            if (request.pause_minutes < 1 || request.pause_minutes > kMaxPauseMinutes) {
+                error = "pause takes 1 to " + std::to_string(kMaxPauseMinutes) + " minutes";
+                return false;
+            }
+        }
+    } else if (command == "resume") {
+        request.command = ControlCommand::kResume;
+    } else if (command == "nudge") {
+        request.command = ControlCommand::kNudge;
+    } else if (command == "status") {
+        request.command = ControlCommand::kStatus;
+    } else if (command == "set") {
+        request.command = ControlCommand::kSet;
+        std::getline(iss, request.options);
+        
+        // The watcher keeps following the file it started with
+        std::istringstream options(request.options);
+        while (options >> argument) {
+            if (argument == "--config") {
+                error = "--config cannot be changed at runtime";
+                return false;
+            }
+        }
+        return true;
+    } else if (command == "trace") {
+        request.command = ControlCommand::kTrace;
+        if (!(iss >> request.path)) {
+            error = "trace takes a file name";
+            return false;
+        }
+    } else {
+        error = "unknown command '" + command + "'";
+        return false;
+    }
+    
+    if (iss >> argument) {
+        error = "unexpected argument '" + argument + "'";
+        return false;
+    }
+    return true;
+}
+
+bool GetControlRequest(const std::string& cmd_line, std::string& request) {
+    std::istringstream iss(cmd_line);
+    std::string token;
+    if (!(iss >> token) || token != "--ctl") {
+        return false;
+    }
+    
+    request.clear();
+    while (iss >> token) {
+        if (!request.empty()) {
+            request += ' ';
+        }
+        request += token;
+    }
+    return true;
+}
+
+std::string FormatStatusReply(uint64_t state, uint64_t resume_in_ms, uint64_t schedule_in_ms, PowerSource source,
+                              bool power_request, const Config& config, const Stats& stats) {
+    const char* source_name = source == PowerSource::kAc ? "ac"
+                            : source == PowerSource::kBattery ? "battery" : "saver";
+    // A power request is reported as mode=power
+    if (state == StatusSnapshot::kPowerRequest) {
+        state = StatusSnapshot::kRunning;
+    }
+    char reply[kMaxControlMessage];
+    std::snprintf(reply, sizeof(reply),
+                  "ok state=%s resume_in=%llu schedule_in=%llu source=%s mode=%s short=%d long=%d distance=%d slack=%d "
+                  "jitter=%d moves=%llu wakeups=%llu",
+                  StatusStateName(state),
+                  (unsigned long long)(resume_in_ms + 999) / 1000,
+                  (unsigned long long)(schedule_in_ms + 999) / 1000, source_name,
+                  power_request ? "power" : config.auto_mode ? "auto" : (config.gesture ? "gesture" : "move"),
+                  config.short_delay, config.long_delay, config.distance, config.slack_percent, config.jitter_percent,
+                  (unsigned long long)stats.inject_calls.load(std::memory_order_relaxed),
+                  (unsigned long long)stats.wakeups.load(std::memory_order_relaxed));
+    return reply;
+}
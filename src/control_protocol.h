@@ -0,0 +1,49 @@
+#pragma once
+
+#include "config.h"
+#include "stats.h"
+#include "status_page.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Control requests and replies are single text messages:
+//
+//   pause [MINUTES]   pause, optionally resuming by itself after MINUTES
+//   resume
+//   nudge             move the mouse once, right now
+//   status
+//   set OPTIONS       apply command line options to the running instance
+//   trace PATH        write the decision trace to PATH (absolute)
+//
+// Replies start with "ok" or "error", followed by details.
+constexpr size_t kMaxControlMessage = 512;
+constexpr int kMaxPauseMinutes = 1440;
+
+enum class ControlCommand {
+    kPause,
+    kResume,
+    kNudge,
+    kStatus,
+    kSet,
+    kTrace,
+};
+
+struct ControlRequest {
+    ControlCommand command = ControlCommand::kStatus;
+    int pause_minutes = 0;      // kPause: 0 means until resumed
+    std::string options;        // kSet: command line options
+    std::string path;           // kTrace: file to write
+};
+
+bool ParseControlRequest(const std::string& text, ControlRequest& request, std::string& error);
+
+// Client mode: true if the command line starts with --ctl, with the
+// request being the rest of it
+bool GetControlRequest(const std::string& cmd_line, std::string& request);
+
+// Reply to "status" for a StatusSnapshot::State; resume_in_ms is 0 unless
+// a timed pause is running, schedule_in_ms is 0 unless a schedule has a
+// next transition. config is the one in effect.
+std::string FormatStatusReply(uint64_t state, uint64_t resume_in_ms, uint64_t schedule_in_ms, PowerSource source,
+                              bool power_request, const Config& config, const Stats& stats);
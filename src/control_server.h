@@ -0,0 +1,83 @@
+#pragma once
+
+#include "control_protocol.h"
+#include "reactor.h"
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Local control endpoint served from the reactor thread: every connection
+// is a handle in the reactor's wait set, with no thread per client. Each
+// request is one message and gets one reply message.
+//
+// Windows: message-mode named pipe \\.\pipe\MouseMover-<session>, a few
+// instances with overlapped I/O. Local clients only.
+// Linux: SOCK_SEQPACKET Unix socket $XDG_RUNTIME_DIR/mm.sock, or
+// /tmp/mm-<uid>/mm.sock in a directory of mode 0700; the socket is 0600.
+class ControlServer {
+public:
+    // Handles one request and returns the reply, on the reactor thread
+    using Handler = std::string (*)(void* context, const std::string& request);
+    
+    ControlServer() = default;
+    ~ControlServer();
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+    
+    bool Start(Reactor& reactor, Handler handler, void* context, std::string& error);
+
+private:
+#ifdef _WIN32
+    static constexpr int kInstances = 4;
+    
+    enum class State {
+        kIdle,
+        kConnecting,
+        kReading,
+        kWriting,
+    };
+    
+    struct Instance {
+        ControlServer* server = nullptr;
+        HANDLE pipe = INVALID_HANDLE_VALUE;
+        HANDLE event = nullptr;
+        OVERLAPPED overlapped = {};
+        State state = State::kIdle;
+        std::string reply;      // kept alive until the write completes
+        char buffer[kMaxControlMessage];
+    };
+    
+    static void OnInstanceEvent(void* context);
+    void Connect(Instance& instance);
+    void Read(Instance& instance);
+    void Write(Instance& instance, const std::string& reply);
+    void Disconnect(Instance& instance);
+    
+    Instance instances_[kInstances];
+#else
+    static constexpr int kMaxClients = 8;
+    
+    struct Client {
+        ControlServer* server = nullptr;
+        int fd = -1;
+    };
+    
+    static void OnListenEvent(void* context);
+    static void OnClientEvent(void* context);
+    void CloseClient(Client& client);
+    
+    int listen_fd_ = -1;
+    std::string socket_path_;
+    Client clients_[kMaxClients];
+#endif
+    
+    Reactor* reactor_ = nullptr;
+    Handler handler_ = nullptr;
+    void* context_ = nullptr;
+};
+
+// Client side: sends one request to the running instance and waits for the
+// reply. False means the request was not delivered.
+bool SendControlRequest(const std::string& request, std::string& reply, std::string& error);
@@ -0,0 +1,236 @@
+#include "control_server.h"
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+// The client gives up on an instance that does not answer within this
+constexpr int kClientTimeoutMs = 2000;
+
+// The runtime directory is private to the user already. In /tmp the name
+// is predictable, so the socket goes into a directory that has to be ours
+// and closed to everyone else; otherwise another user could have put a
+// socket of their own there. The server creates it (`create`).
+bool SocketPath(bool create, std::string& path, std::string& error) {
+    const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir && *runtime_dir) {
+        path = std::string(runtime_dir) + "/mm.sock";
+        return true;
+    }
+    
+    std::string directory = "/tmp/mm-" + std::to_string(getuid());
+    if (create && mkdir(directory.c_str(), S_IRWXU) != 0 && errno != EEXIST) {
+        error = "mkdir " + directory + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (lstat(directory.c_str(), &info) != 0) {
+        error = directory + ": " + std::strerror(errno);
+        return false;
+    }
+    if (!S_ISDIR(info.st_mode) || info.st_uid != getuid() || (info.st_mode & (S_IRWXG | S_IRWXO))) {
+        error = directory + " is not a directory private to this user";
+        return false;
+    }
+    path = directory + "/mm.sock";
+    return true;
+}
+
+// Binds with a umask that makes the socket 0600 from the start, instead of
+// a chmod after bind; umask is per process, which is fine with mm's one
+// thread
+int BindPrivate(int fd, const sockaddr_un& address) {
+    mode_t saved = umask(S_IRWXG | S_IRWXO | S_IXUSR);
+    int result = bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    int saved_errno = errno;
+    umask(saved);
+    errno = saved_errno;
+    return result;
+}
+
+bool MakeAddress(const std::string& path, sockaddr_un& address, std::string& error) {
+    address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        error = "socket path too long: " + path;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+int ConnectSocket(const sockaddr_un& address) {
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+}
+
+ControlServer::~ControlServer() {
+    for (Client& client : clients_) {
+        if (client.fd >= 0) {
+            CloseClient(client);
+        }
+    }
+    if (listen_fd_ >= 0) {
+        reactor_->RemoveHandle(listen_fd_);
+        close(listen_fd_);
+        unlink(socket_path_.c_str());
+    }
+}
+
+bool ControlServer::Start(Reactor& reactor, Handler handler, void* context, std::string& error) {
+    reactor_ = &reactor;
+    handler_ = handler;
+    context_ = context;
+    
+    sockaddr_un address;
+    std::string path;
+    if (!SocketPath(true, path, error) || !MakeAddress(path, address, error)) {
+        return false;
+    }
+    
+    // Sequenced packets keep message boundaries, so a request needs no framing
+    listen_fd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        error = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+    
+    int result = BindPrivate(listen_fd_, address);
+    if (result != 0 && errno == EADDRINUSE) {
+        // Left behind by an instance that died, unless something answers on it
+        int probe = ConnectSocket(address);
+        if (probe >= 0) {
+            close(probe);
+            error = "another instance is listening on " + path;
+            close(listen_fd_);
+            listen_fd_ = -1;
+            return false;
+        }
+        unlink(path.c_str());
+        result = BindPrivate(listen_fd_, address);
+    }
+    if (result != 0) {
+        error = "bind " + path + ": " + std::strerror(errno);
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    socket_path_ = path;
+    
+    if (listen(listen_fd_, kMaxClients) != 0 ||
+        !reactor.AddHandle(listen_fd_, &ControlServer::OnListenEvent, this)) {
+        error = "cannot listen on " + path;
+        return false;
+    }
+    for (Client& client : clients_) {
+        client.server = this;
+    }
+    return true;
+}
+
+void ControlServer::OnListenEvent(void* context) {
+    auto* server = static_cast<ControlServer*>(context);
+    
+    int fd;
+    while ((fd = accept4(server->listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        Client* slot = nullptr;
+        for (Client& client : server->clients_) {
+            if (client.fd < 0) {
+                slot = &client;
+                break;
+            }
+        }
+        // Out of slots: the client sees the connection close
+        if (!slot || !server->reactor_->AddHandle(fd, &ControlServer::OnClientEvent, slot)) {
+            close(fd);
+            continue;
+        }
+        slot->fd = fd;
+    }
+}
+
+void ControlServer::OnClientEvent(void* context) {
+    auto* client = static_cast<Client*>(context);
+    ControlServer* server = client->server;
+    
+    char buffer[kMaxControlMessage];
+    for (;;) {
+        ssize_t length = recv(client->fd, buffer, sizeof(buffer), MSG_TRUNC);
+        if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        if (length <= 0) {
+            server->CloseClient(*client);
+            return;
+        }
+        
+        std::string reply = static_cast<size_t>(length) > sizeof(buffer)
+            ? "error request too long"
+            : server->handler_(server->context_, std::string(buffer, static_cast<size_t>(length)));
+        
+        // A reply fits the socket buffer; a client that lets it fill up is dropped
+        if (send(client->fd, reply.data(), reply.size(), MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {
+            server->CloseClient(*client);
+            return;
+        }
+    }
+}
+
+void ControlServer::CloseClient(Client& client) {
+    reactor_->RemoveHandle(client.fd);
+    close(client.fd);
+    client.fd = -1;
+}
+
+bool SendControlRequest(const std::string& request, std::string& reply, std::string& error) {
+    if (request.empty() || request.size() > kMaxControlMessage) {
+        error = "a request is 1 to " + std::to_string(kMaxControlMessage) + " bytes";
+        return false;
+    }
+    
+    // Checked here as well, so requests never go to a socket someone else
+    // planted
+    sockaddr_un address;
+    std::string path;
+    if (!SocketPath(false, path, error) || !MakeAddress(path, address, error)) {
+        return false;
+    }
+    
+    int fd = ConnectSocket(address);
+    if (fd < 0) {
+        error = "no instance listening on " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    
+    timeval timeout = { kClientTimeoutMs / 1000, (kClientTimeoutMs % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    
+    char buffer[kMaxControlMessage];
+    ssize_t length = -1;
+    if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) >= 0) {
+        length = recv(fd, buffer, sizeof(buffer), 0);
+    }
+    close(fd);
+    
+    if (length <= 0) {
+        error = "no reply from " + path;
+        return false;
+    }
+    reply.assign(buffer, static_cast<size_t>(length));
+    return true;
+}
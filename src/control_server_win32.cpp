@@ -0,0 +1,250 @@
+#include "control_server.h"
+#include <sddl.h>
+#include <memory>
+
+namespace {
+// The client gives up on a busy endpoint after this
+constexpr DWORD kClientTimeoutMs = 2000;
+
+std::wstring PipeName() {
+    // One instance per session, like the tray icon
+    DWORD session = 0;
+    ProcessIdToSessionId(GetCurrentProcessId(), &session);
+    return L"\\\\.\\pipe\\MouseMover-" + std::to_wstring(session);
+}
+
+// Full access for the user we run as and nobody else. The default DACL
+// also gives LocalSystem and administrators full control, and Everyone
+// and anonymous read access.
+bool MakeOwnerOnlyDescriptor(PSECURITY_DESCRIPTOR& descriptor) {
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token)) {
+        return false;
+    }
+    union {
+        TOKEN_USER user;
+        BYTE bytes[sizeof(TOKEN_USER) + SECURITY_MAX_SID_SIZE];
+    } info;
+    DWORD size = 0;
+    bool has_user = GetTokenInformation(token, TokenUser, &info, sizeof(info), &size) != FALSE;
+    CloseHandle(token);
+    
+    wchar_t* sid = nullptr;
+    if (!has_user || !ConvertSidToStringSidW(info.user.User.Sid, &sid)) {
+        return false;
+    }
+    std::wstring sddl = L"D:P(A;;GA;;;" + std::wstring(sid) + L")";
+    LocalFree(sid);
+    return ConvertStringSecurityDescriptorToSecurityDescriptorW(sddl.c_str(), SDDL_REVISION_1, &descriptor,
+                                                                nullptr) != FALSE;
+}
+}
+
+ControlServer::~ControlServer() {
+    for (Instance& instance : instances_) {
+        if (instance.event) {
+            reactor_->RemoveHandle(instance.event);
+        }
+        if (instance.pipe != INVALID_HANDLE_VALUE) {
+            // Outstanding I/O must finish before the OVERLAPPED goes away
+            CancelIo(instance.pipe);
+            DWORD ignored;
+            GetOverlappedResult(instance.pipe, &instance.overlapped, &ignored, TRUE);
+            CloseHandle(instance.pipe);
+        }
+        if (instance.event) {
+            CloseHandle(instance.event);
+        }
+    }
+}
+
+bool ControlServer::Start(Reactor& reactor, Handler handler, void* context, std::string& error) {
+    reactor_ = &reactor;
+    handler_ = handler;
+    context_ = context;
+    
+    PSECURITY_DESCRIPTOR descriptor = nullptr;
+    if (!MakeOwnerOnlyDescriptor(descriptor)) {
+        error = "cannot build the control pipe's access list";
+        return false;
+    }
+    std::unique_ptr<void, HLOCAL (WINAPI*)(HLOCAL)> descriptor_owner(descriptor, &LocalFree);
+    SECURITY_ATTRIBUTES attributes = {sizeof(attributes), descriptor, FALSE};
+    
+    std::wstring name = PipeName();
+    for (int i = 0; i < kInstances; ++i) {
+        Instance& instance = instances_[i];
+        instance.server = this;
+        
+        // Nothing stops another process from creating the name first. If
+        // one did, the first instance fails here rather than joining that
+        // pipe, and we do not start.
+        DWORD open_mode = PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (i == 0 ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0);
+        instance.pipe = CreateNamedPipeW(name.c_str(), open_mode,
+                                         PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                         kInstances, kMaxControlMessage, kMaxControlMessage, 0, &attributes);
+        if (instance.pipe == INVALID_HANDLE_VALUE) {
+            error = i == 0 && GetLastError() == ERROR_ACCESS_DENIED
+                ? "another instance or process owns the control pipe"
+                : "cannot create the control pipe";
+            return false;
+        }
+        
+        // Manual reset, as overlapped I/O expects; each operation clears it when it starts
+        instance.event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (!instance.event || !reactor.AddHandle(instance.event, &ControlServer::OnInstanceEvent, &instance)) {
+            error = "cannot register the control pipe";
+            return false;
+        }
+        Connect(instance);
+    }
+    return true;
+}
+
+void ControlServer::Connect(Instance& instance) {
+    instance.overlapped = {};
+    instance.overlapped.hEvent = instance.event;
+    instance.state = State::kConnecting;
+    
+    if (!ConnectNamedPipe(instance.pipe, &instance.overlapped)) {
+        switch (GetLastError()) {
+            case ERROR_IO_PENDING:
+                break;
+            case ERROR_PIPE_CONNECTED:
+                // Connected between CreateNamedPipe and now; no completion will signal
+                Read(instance);
+                break;
+            default:
+                // Nothing pending, so the event stays clear and the instance idles
+                instance.state = State::kIdle;
+                ResetEvent(instance.event);
+                break;
+        }
+    }
+}
+
+void ControlServer::Read(Instance& instance) {
+    instance.overlapped = {};
+    instance.overlapped.hEvent = instance.event;
+    instance.state = State::kReading;
+    
+    // Completes through the event even when it finishes right away
+    if (!ReadFile(instance.pipe, instance.buffer, sizeof(instance.buffer), nullptr, &instance.overlapped) &&
+        GetLastError() != ERROR_IO_PENDING) {
+        Disconnect(instance);
+    }
+}
+
+void ControlServer::Write(Instance& instance, const std::string& reply) {
+    instance.reply = reply;
+    instance.overlapped = {};
+    instance.overlapped.hEvent = instance.event;
+    instance.state = State::kWriting;
+    
+    if (!WriteFile(instance.pipe, instance.reply.data(), static_cast<DWORD>(instance.reply.size()),
+                   nullptr, &instance.overlapped) &&
+        GetLastError() != ERROR_IO_PENDING) {
+        Disconnect(instance);
+    }
+}
+
+void ControlServer::Disconnect(Instance& instance) {
+    // Ready for the next client on the same instance
+    DisconnectNamedPipe(instance.pipe);
+    Connect(instance);
+}
+
+void ControlServer::OnInstanceEvent(void* context) {
+    auto* instance = static_cast<Instance*>(context);
+    ControlServer* server = instance->server;
+    
+    DWORD bytes = 0;
+    BOOL succeeded = GetOverlappedResult(instance->pipe, &instance->overlapped, &bytes, FALSE);
+    switch (instance->state) {
+        case State::kConnecting:
+            if (succeeded) {
+                server->Read(*instance);
+            } else {
+                server->Disconnect(*instance);
+            }
+            break;
+        
+        case State::kReading:
+            if (succeeded) {
+                std::string request(instance->buffer, bytes);
+                server->Write(*instance, server->handler_(server->context_, request));
+            } else {
+                // Client closed its end, or sent more than a request can hold
+                server->Disconnect(*instance);
+            }
+            break;
+        
+        case State::kWriting:
+            if (succeeded) {
+                server->Read(*instance);
+            } else {
+                server->Disconnect(*instance);
+            }
+            break;
+        
+        case State::kIdle:
+            ResetEvent(instance->event);
+            break;
+    }
+}
+
+bool SendControlRequest(const std::string& request, std::string& reply, std::string& error) {
+    if (request.empty() || request.size() > kMaxControlMessage) {
+        error = "a request is 1 to " + std::to_string(kMaxControlMessage) + " bytes";
+        return false;
+    }
+    
+    std::wstring name = PipeName();
+    
+    HANDLE pipe = INVALID_HANDLE_VALUE;
+    for (;;) {
+        pipe = CreateFileW(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING,
+                           FILE_FLAG_OVERLAPPED, nullptr);
+        if (pipe != INVALID_HANDLE_VALUE) {
+            break;
+        }
+        // All instances busy: wait for one to free up
+        if (GetLastError() != ERROR_PIPE_BUSY || !WaitNamedPipeW(name.c_str(), kClientTimeoutMs)) {
+            error = "no instance is running in this session";
+            return false;
+        }
+    }
+    
+    // One call writes the request and reads the reply. Overlapped, so a
+    // hung instance costs kClientTimeoutMs rather than blocking for good.
+    DWORD mode = PIPE_READMODE_MESSAGE;
+    char buffer[kMaxControlMessage];
+    DWORD length = 0;
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    bool succeeded = false;
+    bool timed_out = false;
+    if (overlapped.hEvent && SetNamedPipeHandleState(pipe, &mode, nullptr, nullptr)) {
+        succeeded = TransactNamedPipe(pipe, const_cast<char*>(request.data()), static_cast<DWORD>(request.size()),
+                                      buffer, sizeof(buffer), &length, &overlapped);
+        if (!succeeded && GetLastError() == ERROR_IO_PENDING) {
+            timed_out = WaitForSingleObject(overlapped.hEvent, kClientTimeoutMs) != WAIT_OBJECT_0;
+            if (timed_out) {
+                CancelIo(pipe);
+            }
+            // Outstanding I/O must finish before the buffers go away
+            succeeded = GetOverlappedResult(pipe, &overlapped, &length, TRUE) && !timed_out;
+        }
+    }
+    if (overlapped.hEvent) {
+        CloseHandle(overlapped.hEvent);
+    }
+    CloseHandle(pipe);
+    
+    if (!succeeded) {
+        error = timed_out ? "no reply within " + std::to_string(kClientTimeoutMs) + " ms" : "control request failed";
+        return false;
+    }
+    reply.assign(buffer, length);
+    return true;
+}
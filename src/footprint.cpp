@@ -0,0 +1,75 @@
+#include "footprint.h"
+#include "random.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <malloc.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32) && defined(SYS_ioprio_set)
+namespace {
+// ioprio_set(2) has no libc wrapper
+constexpr int kIoprioWhoProcess = 1;
+constexpr int kIoprioClassIdle = 3;
+constexpr int kIoprioClassShift = 13;
+}
+#endif
+
+void ReduceFootprint() {
+#ifdef _WIN32
+    // Also the default page priority for everything the process maps later
+    MEMORY_PRIORITY_INFORMATION priority = {};
+    priority.MemoryPriority = MEMORY_PRIORITY_VERY_LOW;
+    SetProcessInformation(GetCurrentProcess(), ProcessMemoryPriority, &priority, sizeof(priority));
+#endif
+    TrimWorkingSet();
+}
+
+void TrimWorkingSet() {
+#ifdef _WIN32
+    HeapCompact(GetProcessHeap(), 0);
+    SetProcessWorkingSetSize(GetCurrentProcess(), static_cast<SIZE_T>(-1), static_cast<SIZE_T>(-1));
+#elif defined(__GLIBC__)
+    // Linux has no per-process page priority, and anonymous pages stay
+    // resident without swap; what can go back is the heap's free memory
+    malloc_trim(0);
+#endif
+}
+
+void EnterEfficiencyMode() {
+#ifdef _WIN32
+    // EcoQoS on Windows 11: efficient cores at a low clock; Windows 10
+    // throttles execution speed instead
+    PROCESS_POWER_THROTTLING_STATE throttling = {};
+    throttling.Version = PROCESS_POWER_THROTTLING_CURRENT_VERSION;
+    throttling.ControlMask = PROCESS_POWER_THROTTLING_EXECUTION_SPEED;
+    throttling.StateMask = PROCESS_POWER_THROTTLING_EXECUTION_SPEED;
+    SetProcessInformation(GetCurrentProcess(), ProcessPowerThrottling, &throttling, sizeof(throttling));
+    
+    // Background mode lowers I/O and memory priority on top of the CPU's
+    SetPriorityClass(GetCurrentProcess(), IDLE_PRIORITY_CLASS);
+    SetPriorityClass(GetCurrentProcess(), PROCESS_MODE_BACKGROUND_BEGIN);
+#else
+    // Nice still applies where SCHED_IDLE is refused, e.g. in some containers
+    setpriority(PRIO_PROCESS, 0, 19);
+    sched_param param = {};
+    sched_setscheduler(0, SCHED_IDLE, &param);
+#ifdef SYS_ioprio_set
+    syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, kIoprioClassIdle << kIoprioClassShift);
+#endif
+#endif
+}
+
+uint64_t DeferredStartMs(int start_delay, int long_delay, uint64_t seed) {
+    int bound = start_delay < long_delay ? start_delay : long_delay;
+    if (bound <= 0) {
+        return 0;
+    }
+    Random random(seed);
+    return random.Next() % (static_cast<uint64_t>(bound) * 1000 + 1);
+}
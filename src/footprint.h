@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+// Footprint mode (--footprint), for hosts running hundreds of sessions.
+//
+// ReduceFootprint() runs once initialization is done. It moves the
+// process to the lowest memory priority (Windows 8+), so its pages are the
+// first to be reclaimed. Then it returns free heap memory to the OS and
+// empties the working set. Only the pages the steady-state loop touches
+// come back.
+void ReduceFootprint();
+
+// Empties the working set again after a one-off burst such as the tray menu
+void TrimWorkingSet();
+
+// Efficiency mode (--efficiency), to stay out of the way of a logon.
+//
+// EnterEfficiencyMode() runs before anything else. It opts the process
+// into EcoQoS (power throttling on Windows 10) and drops it to idle CPU
+// priority and background I/O; on Linux SCHED_IDLE, nice 19 and the idle
+// I/O class. mm then only runs on otherwise idle CPUs, which is plenty for
+// a few moves a minute.
+void EnterEfficiencyMode();
+
+// How long after start the rest of startup waits in efficiency mode: a
+// random point within `start_delay` seconds, so the instances of a logon
+// storm spread out, but never past `long_delay`, before which the first
+// move would not come anyway
+uint64_t DeferredStartMs(int start_delay, int long_delay, uint64_t seed);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+
+// Screen rectangle in desktop coordinates, right/bottom exclusive
+struct ScreenRect {
+    int left = 0;
+    int top = 0;
+    int right = 0;
+    int bottom = 0;
+};
+
+// Platform input layer used by the mouse engine: cursor queries, synthetic
+// input and user idle time. Implementations must exclude the input they
+// inject themselves from GetUserIdleTime().
+class InputBackend {
+public:
+    virtual ~InputBackend() = default;
+    
+    virtual bool GetCursorPosition(int& x, int& y) = 0;
+    
+    // Injects a relative mouse movement
+    virtual bool MoveCursorRelative(int dx, int dy) = 0;
+    
+    // Moves the cursor from (x, y) by (dx, dy) and straight back to (x, y)
+    // in one batched injection of absolute positions, so pointer
+    // acceleration cannot leave any drift
+    virtual bool NudgeCursor(int x, int y, int dx, int dy) = 0;
+    
+    // Bounds of the monitor showing the given point. Served from a layout
+    // cached until the next RefreshMonitors(), so it is cheap per tick.
+    virtual ScreenRect GetMonitorBounds(int x, int y) = 0;
+    
+    // Re-reads the monitor layout after a display configuration change
+    virtual void RefreshMonitors() = 0;
+    
+    // Time elapsed since the last keyboard or mouse input from the user
+    virtual std::chrono::milliseconds GetUserIdleTime() = 0;
+    
+    // Earliest idle timeout after which the OS blanks, locks or sleeps,
+    // counted from the last input including ours; zero if there is none
+    virtual std::chrono::milliseconds GetIdleTimeout() = 0;
+};
@@ -0,0 +1,156 @@
+#include "logind_power_request.h"
+#include <dbus/dbus.h>
+#include <unistd.h>
+
+namespace {
+constexpr uint64_t kCallTimeoutMs = 5000;
+}
+
+LogindPowerRequest::~LogindPowerRequest() {
+    Release();
+    if (connection_) {
+        reactor_->Timers().Cancel(timeout_timer_);
+        if (bus_fd_ >= 0) {
+            reactor_->RemoveHandle(bus_fd_);
+        }
+        dbus_connection_close(connection_);
+        dbus_connection_unref(connection_);
+    }
+}
+
+bool LogindPowerRequest::Start(Reactor& reactor, std::string& error) {
+    reactor_ = &reactor;
+    
+    DBusError bus_error;
+    dbus_error_init(&bus_error);
+    
+    // Private connection, so closing it does not disturb anyone sharing the bus
+    connection_ = dbus_bus_get_private(DBUS_BUS_SYSTEM, &bus_error);
+    if (!connection_) {
+        error = std::string("Cannot connect to the system bus: ") + bus_error.message;
+        dbus_error_free(&bus_error);
+        return false;
+    }
+    dbus_connection_set_exit_on_disconnect(connection_, FALSE);
+    
+    int fd = -1;
+    if (!dbus_connection_get_unix_fd(connection_, &fd) || !reactor.AddHandle(fd, &LogindPowerRequest::OnBusEvent, this)) {
+        error = "Cannot watch the system bus";
+        dbus_connection_close(connection_);
+        dbus_connection_unref(connection_);
+        connection_ = nullptr;
+        return false;
+    }
+    bus_fd_ = fd;
+    return true;
+}
+
+bool LogindPowerRequest::Acquire(std::string& error) {
+    wanted_ = true;
+    if (inhibit_fd_ >= 0 || inhibit_serial_) {
+        return true;
+    }
+    if (bus_fd_ < 0) {
+        error = "logind refused the inhibitor: lost the system bus";
+        return false;
+    }
+    
+    DBusMessage* call = dbus_message_new_method_call("org.freedesktop.login1", "/org/freedesktop/login1",
+                                                     "org.freedesktop.login1.Manager", "Inhibit");
+    const char* what = "idle:sleep";
+    const char* who = "mm";
+    const char* why = "Mouse Mover keep-awake mode";
+    const char* mode = "block";
+    dbus_uint32_t serial = 0;
+    bool sent = call && dbus_message_append_args(call, DBUS_TYPE_STRING, &what, DBUS_TYPE_STRING, &who,
+                                                 DBUS_TYPE_STRING, &why, DBUS_TYPE_STRING, &mode,
+                                                 DBUS_TYPE_INVALID) &&
+                dbus_connection_send(connection_, call, &serial);
+    if (call) {
+        dbus_message_unref(call);
+    }
+    if (!sent) {
+        error = "logind refused the inhibitor: cannot send the request";
+        return false;
+    }
+    
+    // Never waits for logind: the reply comes back through OnBusEvent
+    dbus_connection_flush(connection_);
+    inhibit_serial_ = serial;
+    reactor_->Timers().Schedule(timeout_timer_, Reactor::Now() + kCallTimeoutMs);
+    return true;
+}
+
+void LogindPowerRequest::Release() {
+    // A reply still on its way is closed when it comes in
+    wanted_ = false;
+    if (inhibit_fd_ >= 0) {
+        close(inhibit_fd_);
+        inhibit_fd_ = -1;
+    }
+}
+
+void LogindPowerRequest::OnBusEvent(void* context) {
+    auto* request = static_cast<LogindPowerRequest*>(context);
+    std::string error;
+    
+    // The queue is emptied here: a message left in it would not wake the
+    // reactor again
+    dbus_connection_read_write(request->connection_, 0);
+    while (DBusMessage* message = dbus_connection_pop_message(request->connection_)) {
+        if (request->inhibit_serial_ && dbus_message_get_reply_serial(message) == request->inhibit_serial_) {
+            request->inhibit_serial_ = 0;
+            request->reactor_->Timers().Cancel(request->timeout_timer_);
+            request->TakeReply(message, error);
+        }
+        dbus_message_unref(message);
+    }
+    
+    // A lost bus answers nothing more; a held inhibitor stays with its fd
+    if (!dbus_connection_get_is_connected(request->connection_)) {
+        request->reactor_->RemoveHandle(request->bus_fd_);
+        request->bus_fd_ = -1;
+        if (request->inhibit_serial_) {
+            request->inhibit_serial_ = 0;
+            request->reactor_->Timers().Cancel(request->timeout_timer_);
+            if (request->wanted_) {
+                error = "logind refused the inhibitor: lost the system bus";
+            }
+        }
+    }
+    
+    if (!error.empty()) {
+        request->Fail(error);
+    }
+}
+
+void LogindPowerRequest::OnTimeout(void* context) {
+    // A late reply no longer matches, and its fd is closed with the message
+    auto* request = static_cast<LogindPowerRequest*>(context);
+    request->inhibit_serial_ = 0;
+    if (request->wanted_) {
+        request->Fail("logind refused the inhibitor: no reply");
+    }
+}
+
+void LogindPowerRequest::TakeReply(DBusMessage* reply, std::string& error) {
+    DBusError bus_error;
+    dbus_error_init(&bus_error);
+    
+    // The reply carries a duplicate of the fd that we now own
+    int fd = -1;
+    if (!dbus_set_error_from_message(&bus_error, reply) &&
+        !dbus_message_get_args(reply, &bus_error, DBUS_TYPE_UNIX_FD, &fd, DBUS_TYPE_INVALID)) {
+        fd = -1;
+    }
+    
+    if (fd >= 0 && wanted_) {
+        inhibit_fd_ = fd;
+    } else if (fd >= 0) {
+        close(fd);
+    } else if (wanted_) {
+        error = std::string("logind refused the inhibitor: ") +
+                (dbus_error_is_set(&bus_error) ? bus_error.message : "no reply");
+    }
+    dbus_error_free(&bus_error);
+}
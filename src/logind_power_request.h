@@ -0,0 +1,44 @@
+#pragma once
+
+#include "power_request.h"
+#include "reactor.h"
+#include "timer_wheel.h"
+#include <cstdint>
+
+struct DBusConnection;
+struct DBusMessage;
+
+// systemd-logind "idle:sleep" inhibitor taken over the system D-Bus. The
+// inhibitor lives as long as we hold the returned file descriptor. The
+// private bus connection is opened once by Start and its socket is
+// registered with the reactor: Inhibit is sent without waiting, and the
+// fd is taken from the reply when it comes in. An error reply, no reply
+// within the call timeout or a lost bus goes to the failed callback.
+// DBUS_SYSTEM_BUS_ADDRESS points it at another bus, e.g. a local
+// dbus-daemon for testing.
+class LogindPowerRequest : public PowerRequest {
+public:
+    LogindPowerRequest() = default;
+    ~LogindPowerRequest() override;
+    LogindPowerRequest(const LogindPowerRequest&) = delete;
+    LogindPowerRequest& operator=(const LogindPowerRequest&) = delete;
+    
+    bool Start(Reactor& reactor, std::string& error);
+    
+    // True once Inhibit is on its way; the fd follows with the reply
+    bool Acquire(std::string& error) override;
+    void Release() override;
+    
+private:
+    static void OnBusEvent(void* context);
+    static void OnTimeout(void* context);
+    void TakeReply(DBusMessage* reply, std::string& error);
+    
+    Reactor* reactor_ = nullptr;
+    DBusConnection* connection_ = nullptr;
+    int bus_fd_ = -1;
+    int inhibit_fd_ = -1;
+    uint32_t inhibit_serial_ = 0;       // Inhibit call awaiting its reply
+    bool wanted_ = false;               // between Acquire and Release
+    TimerWheel::Timer timeout_timer_{&LogindPowerRequest::OnTimeout, this};
+};
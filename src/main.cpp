@@ -1,13 +1,26 @@
 #include <windows.h>
 #include <shellapi.h>
 #include "resource.h"
-#include <thread>
+#include "app_controller.h"
+#include "calibration.h"
+#include "clock.h"
+#include "config.h"
+#include "config_watcher.h"
+#include "control_server.h"
+#include "footprint.h"
+#include "mouse_engine.h"
+#include "power_source.h"
+#include "reactor.h"
+#include "session_monitor.h"
+#include "stats.h"
+#include "status_page.h"
+#include "trace.h"
+#include "tray_tooltip.h"
+#include "win32_input_backend.h"
+#include "win32_power_request.h"
 #include <chrono>
+#include <ctime>
 #include <string>
-#include <sstream>
-#include <atomic>
-#include <mutex>
-#include <stdexcept>
 #include <memory>
 
 // Constants
@@ -16,45 +29,60 @@ constexpr UINT kTrayIconMessage = WM_USER + 1;
 constexpr UINT kTrayIconId = 1;
 constexpr UINT kMenuIdExit = 1001;
 constexpr UINT kMenuIdPause = 1002;
+constexpr UINT kMenuIdStats = 1003;
 
-constexpr int kMinDelaySeconds = 1;
-constexpr int kMaxDelaySeconds = 3600;
-constexpr int kMaxLongDelaySeconds = 7200;
-constexpr int kMinDistance = 1;
-constexpr int kMaxDistance = 100;
-constexpr int kScreenBorderMargin = 10;
+// Retry interval while the shell is not ready to take the tray icon
+constexpr uint64_t kTrayRetryMs = 2000;
+
+// How often the statistics line in the tooltip is refreshed
+constexpr uint64_t kStatsRefreshMs = 60000;
 
 constexpr const wchar_t* kWindowClassName = L"MouseMoverClass";
 constexpr const wchar_t* kWindowTitle = L"Mouse Mover";
-}
 
-// Configuration structure
-struct Config {
-    int short_delay = 5;    // seconds between moves
-    int long_delay = 30;    // seconds to wait after user activity
-    int distance = 5;       // pixels to move
-};
+// Seed of the move jitter: differs between sessions and between cloned
+// VMs that log on in the same instant
+uint64_t SessionSeed() {
+    LARGE_INTEGER counter = {};
+    QueryPerformanceCounter(&counter);
+    DWORD session = 0;
+    ProcessIdToSessionId(GetCurrentProcessId(), &session);
+    uint64_t seed = static_cast<uint64_t>(counter.QuadPart) ^ (static_cast<uint64_t>(session) << 32) ^
+                    GetCurrentProcessId();
+    
+    wchar_t name[MAX_COMPUTERNAME_LENGTH + 1] = {};
+    DWORD length = MAX_COMPUTERNAME_LENGTH + 1;
+    if (GetComputerNameW(name, &length)) {
+        for (DWORD i = 0; i < length; ++i) {
+            seed = (seed ^ name[i]) * 0x100000001b3ull;
+        }
+    }
+    return seed;
+}
+}
 
-// Main application class
-class MouseMoverApp {
+// Main application class; what is not Windows-specific lives in AppController
+class MouseMoverApp : private AppController::Host {
 public:
     MouseMoverApp();
-    ~MouseMoverApp();
+    ~MouseMoverApp() override;
     
     int Run(HINSTANCE instance, LPWSTR cmd_line);
-
+    
 private:
     // Core functionality
     bool Initialize(HINSTANCE instance, const std::string& cmd_line);
+    void Start();
+    static void OnStartTimer(void* context);
     void Cleanup();
     void RunMessageLoop();
     
     // Command line parsing
-    bool ParseCommandLine(const std::string& cmd_line);
-    bool ParseDelayParameter(const std::string& token, int& target, int min_val, int max_val, const std::string& param_name);
-    bool ParseDistanceParameter(const std::string& token);
+    bool LoadConfig(const std::string& cmd_line);
+    static void OnConfigChanged(void* context);
     void ShowHelp() const;
-    bool ValidateConfig() const;
+    static std::wstring Utf8ToWide(const std::string& text);
+    static const wchar_t* Utf8ToWide(const char* text, wchar_t* buffer, int size);
     
     // Window management
     bool RegisterWindowClass(HINSTANCE instance);
@@ -66,30 +94,47 @@ private:
     void CreateTrayIcon();
     void ShowContextMenu();
     void UpdateTrayTooltip();
-    
-    // Mouse movement
-    void MouseThreadFunc();
-    void MoveMouse();
-    bool ShouldPauseForUserActivity();
+    void ShowStats() const;
+    static void OnTrayTimer(void* context);
+    static void OnStatsTimer(void* context);
+    static void OnSessionChanged(void* context);
+    static void OnPowerSourceChanged(void* context);
+    
+    // Control endpoint (--ctl)
+    static int RunControlClient(const std::string& request);
+    static std::string OnControlRequest(void* context, const std::string& request);
+    
+    // AppController::Host
+    bool IsSessionActive() const override { return session_monitor_.IsActive(); }
+    bool IsSessionLocked() const override { return session_monitor_.IsLocked(); }
+    PowerSource CurrentPowerSource() const override { return power_source_.Current(); }
+    void ApplyPolicy(Config& config) const override { ConfigWatcher::ApplyPolicy(config); }
+    void SetTimerSlack(int percent) override { reactor_.SetTimerSlack(percent); }
+    void PublishStatus(StatusSnapshot& status, const Stats& stats, uint64_t now) override;
+    void OnStateChanged() override;
+    void OnCalibrated(const CalibrationRecord& record) override;
+    void Report(const std::string& message) override;
     
     // Member variables
     HWND hwnd_;
     NOTIFYICONDATA tray_icon_data_;
-    std::atomic<bool> is_paused_{false};
-    std::atomic<bool> is_running_{true};
-    Config config_;
-    std::mutex tray_mutex_;
-    std::unique_ptr<std::thread> mouse_thread_;
-    
-    // Mouse movement state
-    struct MouseState {
-        int move_pattern = 0;  // 0=horizontal, 1=vertical, 2=diagonal
-        int direction_x = 1;
-        int direction_y = 1;
-        POINT last_user_pos = {-1, -1};
-        std::chrono::steady_clock::time_point last_user_activity = std::chrono::steady_clock::now();
-        bool user_was_active = false;
-    } mouse_state_;
+    bool tray_icon_added_ = false;
+    std::unique_ptr<InputBackend> input_backend_;
+    
+    // Everything runs on the message loop thread, driven by the reactor's timer wheel
+    Reactor reactor_;
+    TimerWheel::Timer start_timer_{&MouseMoverApp::OnStartTimer, this};
+    TimerWheel::Timer tray_timer_{&MouseMoverApp::OnTrayTimer, this};
+    TimerWheel::Timer stats_timer_{&MouseMoverApp::OnStatsTimer, this};
+    ConfigWatcher config_watcher_;
+    ControlServer control_server_;
+    StatusPageWriter status_page_;
+    TraceRing trace_;
+    SystemClock clock_;
+    SessionMonitor session_monitor_;
+    PowerSourceMonitor power_source_;
+    AppController controller_{*this, reactor_.Timers(), clock_, trace_};
+    std::unique_ptr<MouseEngine> mouse_engine_;
 };
 
 // Global app instance for window procedure callback
@@ -118,6 +163,11 @@ int MouseMoverApp::Run(HINSTANCE instance, LPWSTR cmd_line) {
     std::string cmd_line_str(size - 1, 0);
     WideCharToMultiByte(CP_UTF8, 0, cmd_line, -1, &cmd_line_str[0], size, nullptr, nullptr);
     
+    std::string request;
+    if (GetControlRequest(cmd_line_str, request)) {
+        return RunControlClient(request);
+    }
+    
     if (!Initialize(instance, cmd_line_str)) {
         return 1;
     }
@@ -127,12 +177,20 @@ int MouseMoverApp::Run(HINSTANCE instance, LPWSTR cmd_line) {
 }
 
 bool MouseMoverApp::Initialize(HINSTANCE instance, const std::string& cmd_line) {
-    if (!ParseCommandLine(cmd_line)) {
+    if (!LoadConfig(cmd_line)) {
         return false;
     }
     
-    if (!ValidateConfig()) {
-        return false;
+    // First, so the rest of startup already runs at the low priority
+    const Config& config = controller_.Current();
+    if (config.efficiency) {
+        EnterEfficiencyMode();
+    }
+    
+    // Per-monitor DPI awareness puts the cursor position and the monitor
+    // rectangles in the same physical-pixel space on scaled monitors
+    if (!SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2)) {
+        SetProcessDPIAware();
     }
     
     if (!RegisterWindowClass(instance)) {
@@ -145,134 +203,142 @@ bool MouseMoverApp::Initialize(HINSTANCE instance, const std::string& cmd_line)
         return false;
     }
     
-    CreateTrayIcon();
-    
-    // Start mouse movement thread
-    mouse_thread_ = std::make_unique<std::thread>(&MouseMoverApp::MouseThreadFunc, this);
-    
+    if (!reactor_.Initialize()) {
+        MessageBoxW(nullptr, L"Failed to initialize event loop", L"Error", MB_OK | MB_ICONERROR);
+        return false;
+    }
+    reactor_.SetTimerSlack(config.slack_percent);
+    
+    // The tray, the watchers and the mover wait out the logon storm; only
+    // the message loop runs until then
+    uint64_t delay = config.efficiency ? DeferredStartMs(config.start_delay, config.long_delay, SessionSeed()) : 0;
+    if (delay) {
+        reactor_.Timers().Schedule(start_timer_, Reactor::Now() + delay);
+    } else {
+        Start();
+    }
     return true;
 }
 
-void MouseMoverApp::Cleanup() {
-    is_running_ = false;
+void MouseMoverApp::Start() {
+    const Config& config = controller_.Current();
     
-    if (mouse_thread_ && mouse_thread_->joinable()) {
-        mouse_thread_->join();
+    // Changes to the file or policy are picked up without a restart
+    if (!config_watcher_.Start(reactor_, config.config_path, &MouseMoverApp::OnConfigChanged, this)) {
+        OutputDebugStringW(L"Mouse Mover: cannot watch the configuration for changes\n");
     }
     
-    Shell_NotifyIcon(NIM_DELETE, &tray_icon_data_);
-    
-    if (tray_icon_data_.hIcon) {
-        DestroyIcon(tray_icon_data_.hIcon);
-    }
-}
-
-void MouseMoverApp::RunMessageLoop() {
-    MSG msg;
-    while (GetMessage(&msg, nullptr, 0, 0)) {
-        TranslateMessage(&msg);
-        DispatchMessage(&msg);
+    // Runs without it: the tray menu still works
+    std::string error;
+    if (!control_server_.Start(reactor_, &MouseMoverApp::OnControlRequest, this, error)) {
+        OutputDebugStringW(Utf8ToWide("Mouse Mover: no control endpoint: " + error + "\n").c_str());
     }
-}
-
-bool MouseMoverApp::ParseCommandLine(const std::string& cmd_line) {
-    if (cmd_line.empty()) {
-        return true; // No parameters, use defaults
+    if (!status_page_.Open(error)) {
+        OutputDebugStringW(Utf8ToWide("Mouse Mover: no status page: " + error + "\n").c_str());
     }
     
-    // Check for help
-    if (cmd_line.find("-h") != std::string::npos || cmd_line.find("--help") != std::string::npos) {
-        ShowHelp();
-        return false;
+    // Without notifications the session counts as always in use
+    if (!session_monitor_.Start(hwnd_, &MouseMoverApp::OnSessionChanged, this, error)) {
+        OutputDebugStringW(Utf8ToWide("Mouse Mover: no session tracking: " + error + "\n").c_str());
+    }
+    if (!power_source_.Start(hwnd_, &MouseMoverApp::OnPowerSourceChanged, this, error)) {
+        OutputDebugStringW(Utf8ToWide("Mouse Mover: no power source tracking: " + error + "\n").c_str());
     }
     
-    // Parse parameters
-    std::istringstream iss(cmd_line);
-    std::string token;
+    CreateTrayIcon();
     
-    while (iss >> token) {
-        if ((token == "-s" || token == "--short-delay") && iss >> token) {
-            if (!ParseDelayParameter(token, config_.short_delay, kMinDelaySeconds, kMaxDelaySeconds, "Short-delay")) {
-                return false;
-            }
-        }
-        else if ((token == "-l" || token == "--long-delay") && iss >> token) {
-            if (!ParseDelayParameter(token, config_.long_delay, 0, kMaxLongDelaySeconds, "Long-delay")) {
-                return false;
-            }
-        }
-        else if ((token == "-d" || token == "--distance") && iss >> token) {
-            if (!ParseDistanceParameter(token)) {
-                return false;
-            }
-        }
+    auto input_backend = std::make_unique<Win32InputBackend>();
+    if (config.input_hooks && !input_backend->EnableInputHooks(&controller_.Statistics().hook_cost_ns)) {
+        OutputDebugStringW(L"Mouse Mover: input hooks unavailable, using GetLastInputInfo\n");
+    }
+    input_backend_ = std::move(input_backend);
+    if (!config.trace_path.empty() && !trace_.MapFile(config.trace_path, error)) {
+        OutputDebugStringW(Utf8ToWide("Mouse Mover: tracing in memory: " + error + "\n").c_str());
+    }
+    mouse_engine_ = std::make_unique<MouseEngine>(controller_.Configs(), *input_backend_, clock_,
+                                                  controller_.Statistics(), &trace_);
+    mouse_engine_->SeedJitter(SessionSeed());
+    mouse_engine_->Calibration().Load(LoadCalibration());
+    
+    std::unique_ptr<PowerRequest> power_request;
+    if (config.power_mode) {
+        power_request = std::make_unique<Win32PowerRequest>();
     }
+    controller_.Start(*mouse_engine_, std::move(power_request));
     
-    return true;
+    // Everything touched so far was startup-only
+    if (config.footprint) {
+        ReduceFootprint();
+    }
 }
 
-bool MouseMoverApp::ParseDelayParameter(const std::string& token, int& target, int min_val, int max_val, const std::string& param_name) {
-    try {
-        int value = std::stoi(token);
-        if (value < min_val || value > max_val) {
-            std::wstring error_msg = L"" + std::wstring(param_name.begin(), param_name.end()) + 
-                                   L" must be between " + std::to_wstring(min_val) + 
-                                   L" and " + std::to_wstring(max_val) + L" seconds";
-            MessageBoxW(nullptr, error_msg.c_str(), L"Parameter Error", MB_OK | MB_ICONERROR);
-            return false;
-        }
-        target = value;
-        return true;
-    } catch (const std::exception&) {
-        std::wstring error_msg = L"Invalid " + std::wstring(param_name.begin(), param_name.end()) + L" parameter";
-        MessageBoxW(nullptr, error_msg.c_str(), L"Parameter Error", MB_OK | MB_ICONERROR);
-        return false;
-    }
+void MouseMoverApp::OnStartTimer(void* context) {
+    static_cast<MouseMoverApp*>(context)->Start();
 }
 
-bool MouseMoverApp::ParseDistanceParameter(const std::string& token) {
-    try {
-        int value = std::stoi(token);
-        if (value < kMinDistance || value > kMaxDistance) {
-            MessageBoxW(nullptr, L"Distance must be between 1 and 100 pixels", L"Parameter Error", MB_OK | MB_ICONERROR);
-            return false;
-        }
-        config_.distance = value;
-        return true;
-    } catch (const std::exception&) {
-        MessageBoxW(nullptr, L"Invalid distance parameter", L"Parameter Error", MB_OK | MB_ICONERROR);
-        return false;
+void MouseMoverApp::Cleanup() {
+    controller_.Stop();
+    reactor_.Timers().Cancel(start_timer_);
+    reactor_.Timers().Cancel(tray_timer_);
+    reactor_.Timers().Cancel(stats_timer_);
+    
+    if (tray_icon_added_) {
+        Shell_NotifyIcon(NIM_DELETE, &tray_icon_data_);
+        tray_icon_added_ = false;
+    }
+    
+    if (tray_icon_data_.hIcon) {
+        DestroyIcon(tray_icon_data_.hIcon);
     }
 }
 
-bool MouseMoverApp::ValidateConfig() const {
-    if (config_.short_delay > config_.long_delay) {
-        MessageBoxW(nullptr, L"Short delay must be less than or equal to long delay", L"Parameter Error", MB_OK | MB_ICONERROR);
-        return false;
+void MouseMoverApp::RunMessageLoop() {
+    // Dispatches window messages and timers until WM_QUIT
+    reactor_.Run();
+}
+
+bool MouseMoverApp::LoadConfig(const std::string& cmd_line) {
+    std::string error;
+    switch (controller_.Load(cmd_line, error)) {
+        case ParseResult::kHelp:
+            ShowHelp();
+            return false;
+        case ParseResult::kError:
+            MessageBoxW(nullptr, Utf8ToWide(error).c_str(), L"Parameter Error", MB_OK | MB_ICONERROR);
+            return false;
+        case ParseResult::kOk:
+            break;
     }
     return true;
 }
 
+void MouseMoverApp::OnConfigChanged(void* context) {
+    static_cast<MouseMoverApp*>(context)->controller_.ReloadConfig();
+}
+
+void MouseMoverApp::OnPowerSourceChanged(void* context) {
+    static_cast<MouseMoverApp*>(context)->controller_.UpdateEffectiveConfig();
+}
+
 void MouseMoverApp::ShowHelp() const {
-    std::string help_text = 
-        "Mouse Mover v1.0.3 - Prevents screen lock\n\n"
-        "Usage: mm.exe [OPTIONS]\n\n"
-        "Options:\n"
-        "  -s, --short-delay SECONDS   Short delay between moves (default: 5)\n"
-        "  -l, --long-delay SECONDS    Long delay after user activity (default: 30)\n"
-        "  -d, --distance PIXELS       Distance in pixels to move (default: 5)\n"
-        "  -h, --help                  Show this help\n\n"
-        "Examples:\n"
-        "  mm.exe -s 3 -l 15 -d 10\n"
-        "  mm.exe --short-delay 2 --long-delay 60\n\n"
-        "The application runs in the system tray.\n"
-        "Right-click the tray icon for options.";
-    
-    // Convert to wide string for MessageBox
-    int size = MultiByteToWideChar(CP_UTF8, 0, help_text.c_str(), -1, nullptr, 0);
-    std::wstring w_help_text(size - 1, 0);
-    MultiByteToWideChar(CP_UTF8, 0, help_text.c_str(), -1, &w_help_text[0], size);
-    MessageBoxW(nullptr, w_help_text.c_str(), L"Mouse Mover Help", MB_OK | MB_ICONINFORMATION);
+    static wchar_t text[4096];
+    MessageBoxW(nullptr, Utf8ToWide(GetHelpText(), text, sizeof(text) / sizeof(text[0])), L"Mouse Mover Help",
+                MB_OK | MB_ICONINFORMATION);
+}
+
+std::wstring MouseMoverApp::Utf8ToWide(const std::string& text) {
+    int size = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, nullptr, 0);
+    std::wstring wide(size - 1, 0);
+    MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, &wide[0], size);
+    return wide;
+}
+
+const wchar_t* MouseMoverApp::Utf8ToWide(const char* text, wchar_t* buffer, int size) {
+    // Text that does not fit is cut off rather than dropped
+    if (!MultiByteToWideChar(CP_UTF8, 0, text, -1, buffer, size)) {
+        buffer[size - 1] = L'\0';
+    }
+    return buffer;
 }
 
 bool MouseMoverApp::RegisterWindowClass(HINSTANCE instance) {
@@ -285,10 +351,12 @@ bool MouseMoverApp::RegisterWindowClass(HINSTANCE instance) {
 }
 
 bool MouseMoverApp::CreateMessageWindow(HINSTANCE instance) {
-    hwnd_ = CreateWindowW(
-        kWindowClassName, kWindowTitle,
-        0, 0, 0, 0, 0,
-        HWND_MESSAGE, nullptr, instance, nullptr
+    // Hidden top-level window rather than HWND_MESSAGE: message-only windows
+    // never see broadcasts such as WM_DISPLAYCHANGE
+    hwnd_ = CreateWindowExW(
+        WS_EX_TOOLWINDOW, kWindowClassName, kWindowTitle,
+        WS_POPUP, 0, 0, 0, 0,
+        nullptr, nullptr, instance, nullptr
     );
     
     return hwnd_ != nullptr;
@@ -307,29 +375,54 @@ LRESULT MouseMoverApp::WindowProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lpa
             if (lparam == WM_RBUTTONUP) {
                 ShowContextMenu();
             } else if (lparam == WM_LBUTTONDBLCLK) {
-                is_paused_ = !is_paused_.load();
-                UpdateTrayTooltip();
+                controller_.TogglePause();
             }
             break;
-            
+        
         case WM_COMMAND:
             switch (LOWORD(wparam)) {
-                case kMenuIdPause: {
-                    is_paused_ = !is_paused_.load();
-                    UpdateTrayTooltip();
+                case kMenuIdPause:
+                    controller_.TogglePause();
+                    break;
+                case kMenuIdStats:
+                    ShowStats();
                     break;
-                }
                 case kMenuIdExit:
-                    is_running_ = false;
                     PostQuitMessage(0);
                     break;
             }
             break;
-            
+        
+        case WM_DISPLAYCHANGE:
+        case WM_DPICHANGED:
+            // Monitor layout is cached; these are the only times it changes
+            if (input_backend_) {
+                input_backend_->RefreshMonitors();
+            }
+            break;
+        
+        case WM_WTSSESSION_CHANGE:
+            session_monitor_.OnSessionChange(wparam);
+            break;
+        
+        case WM_POWERBROADCAST:
+            power_source_.OnPowerBroadcast(wparam, lparam);
+            return TRUE;
+        
+        case WM_TIMECHANGE:
+            // The clock or time zone was set; the schedule timer runs on
+            // the monotonic clock and would miss the jump. Before the
+            // deferred start there is no schedule yet.
+            _tzset();
+            if (controller_.IsStarted()) {
+                controller_.UpdateEffectiveConfig();
+            }
+            break;
+        
         case WM_DESTROY:
             PostQuitMessage(0);
             break;
-            
+        
         default:
             return DefWindowProc(hwnd, msg, wparam, lparam);
     }
@@ -354,123 +447,141 @@ void MouseMoverApp::CreateTrayIcon() {
     
     UpdateTrayTooltip();
     
-    if (!Shell_NotifyIcon(NIM_ADD, &tray_icon_data_)) {
-        MessageBoxW(nullptr, L"Failed to create system tray icon.", L"Error", MB_ICONERROR);
+    // The shell may not be up yet during logon; keep retrying from the timer wheel
+    tray_icon_added_ = Shell_NotifyIcon(NIM_ADD, &tray_icon_data_) != FALSE;
+    if (!tray_icon_added_) {
+        reactor_.Timers().Schedule(tray_timer_, Reactor::Now() + kTrayRetryMs);
     }
 }
 
-void MouseMoverApp::UpdateTrayTooltip() {
-    std::lock_guard<std::mutex> lock(tray_mutex_);
-    
-    const wchar_t* status = is_paused_.load() ? L"Mouse Mover - Paused" : L"Mouse Mover - Active";
+void MouseMoverApp::OnTrayTimer(void* context) {
+    auto* app = static_cast<MouseMoverApp*>(context);
     
-    int result = swprintf_s(tray_icon_data_.szTip, sizeof(tray_icon_data_.szTip)/sizeof(wchar_t), 
-                           L"%s (Move: %ds, Wait: %ds)", status, config_.short_delay, config_.long_delay);
-    if (result < 0) {
-        wcscpy_s(tray_icon_data_.szTip, sizeof(tray_icon_data_.szTip)/sizeof(wchar_t), status);
+    app->tray_icon_added_ = Shell_NotifyIcon(NIM_ADD, &app->tray_icon_data_) != FALSE;
+    if (!app->tray_icon_added_ && app->session_monitor_.IsActive()) {
+        app->reactor_.Timers().Schedule(app->tray_timer_, Reactor::Now() + kTrayRetryMs);
     }
-    
-    Shell_NotifyIcon(NIM_MODIFY, &tray_icon_data_);
 }
 
-void MouseMoverApp::ShowContextMenu() {
-    POINT pt;
-    GetCursorPos(&pt);
+void MouseMoverApp::OnStatsTimer(void* context) {
+    auto* app = static_cast<MouseMoverApp*>(context);
     
-    HMENU menu = CreatePopupMenu();
-    
-    // Pause/Resume
-    AppendMenuW(menu, MF_STRING, kMenuIdPause, is_paused_.load() ? L"Resume" : L"Pause");
-    AppendMenu(menu, MF_SEPARATOR, 0, nullptr);
-    
-    AppendMenuW(menu, MF_STRING, kMenuIdExit, L"Exit");
-    
-    SetForegroundWindow(hwnd_);
-    TrackPopupMenu(menu, TPM_RIGHTBUTTON, pt.x, pt.y, 0, hwnd_, nullptr);
-    DestroyMenu(menu);
+    app->UpdateTrayTooltip();
+    if (app->session_monitor_.IsActive()) {
+        app->reactor_.Timers().Schedule(app->stats_timer_, Reactor::Now() + kStatsRefreshMs);
+    }
 }
 
-void MouseMoverApp::MouseThreadFunc() {
-    while (is_running_.load()) {
-        if (!is_paused_.load()) {
-            MoveMouse();
+void MouseMoverApp::UpdateTrayTooltip() {
+    const Config& config = controller_.Current();
+    TrayState state = controller_.IsPaused() ? TrayState::kPaused
+                    : !controller_.IsScheduleActive() ? TrayState::kOffSchedule
+                    : !session_monitor_.IsActive() ? TrayState::kAway : TrayState::kActive;
+    FormatTrayTooltip(state, config, controller_.HasPowerRequest(),
+                      config.show_stats ? &controller_.Statistics() : nullptr,
+                      tray_icon_data_.szTip, sizeof(tray_icon_data_.szTip) / sizeof(wchar_t));
+    
+    if (tray_icon_added_) {
+        Shell_NotifyIcon(NIM_MODIFY, &tray_icon_data_);
+    }
+}
+
+void MouseMoverApp::OnStateChanged() {
+    // Nobody sees the tray while the session is away, so its timers park;
+    // the statistics line is only refreshed while it is shown
+    TimerWheel& timers = reactor_.Timers();
+    bool active = session_monitor_.IsActive();
+    if (active && controller_.Current().show_stats) {
+        if (!stats_timer_.IsArmed()) {
+            timers.Schedule(stats_timer_, Reactor::Now() + kStatsRefreshMs);
         }
-        std::this_thread::sleep_for(std::chrono::seconds(config_.short_delay));
+    } else {
+        timers.Cancel(stats_timer_);
+    }
+    if (!active) {
+        timers.Cancel(tray_timer_);
+    } else if (!tray_icon_added_ && !tray_timer_.IsArmed()) {
+        timers.Schedule(tray_timer_, Reactor::Now());
     }
+    UpdateTrayTooltip();
 }
 
-void MouseMoverApp::MoveMouse() {
-    POINT current_pos;
-    GetCursorPos(&current_pos);
-    
-    // Check if user moved mouse
-    if (current_pos.x != mouse_state_.last_user_pos.x || current_pos.y != mouse_state_.last_user_pos.y) {
-        mouse_state_.last_user_pos = current_pos;
-        mouse_state_.last_user_activity = std::chrono::steady_clock::now();
-        mouse_state_.user_was_active = true;
-        return; // User is active, don't move
+void MouseMoverApp::OnSessionChanged(void* context) {
+    static_cast<MouseMoverApp*>(context)->controller_.OnSessionChanged();
+}
+
+void MouseMoverApp::OnCalibrated(const CalibrationRecord& record) {
+    std::string error;
+    if (!SaveCalibration(record, error)) {
+        Report(error);
     }
-    
-    // Wait for user inactivity period
-    if (mouse_state_.user_was_active) {
-        auto time_since_activity = std::chrono::duration_cast<std::chrono::seconds>(
-            std::chrono::steady_clock::now() - mouse_state_.last_user_activity).count();
-        
-        if (time_since_activity < config_.long_delay) {
-            return; // Still in waiting period
-        }
-        mouse_state_.user_was_active = false;
+}
+
+void MouseMoverApp::Report(const std::string& message) {
+    OutputDebugStringW(Utf8ToWide("Mouse Mover: " + message + "\n").c_str());
+}
+
+void MouseMoverApp::PublishStatus(StatusSnapshot& status, const Stats& stats, uint64_t now) {
+    status.pid = GetCurrentProcessId();
+    status_page_.Publish(status, stats, now);
+}
+
+int MouseMoverApp::RunControlClient(const std::string& request) {
+    std::string reply;
+    std::string error;
+    bool reached = SendControlRequest(request, reply, error);
+    std::string line = (reached ? reply : "mm: " + error) + "\r\n";
+    
+    // A GUI process has no console of its own; print to the caller's
+    AttachConsole(ATTACH_PARENT_PROCESS);
+    HANDLE output = GetStdHandle(reached ? STD_OUTPUT_HANDLE : STD_ERROR_HANDLE);
+    DWORD written;
+    if (output && output != INVALID_HANDLE_VALUE) {
+        WriteFile(output, line.data(), static_cast<DWORD>(line.size()), &written, nullptr);
     }
     
-    // Prepare SendInput structure
-    INPUT input = {};
-    input.type = INPUT_MOUSE;
-    input.mi.dwFlags = MOUSEEVENTF_MOVE;
-    
-    // Calculate movement based on pattern
-    switch (mouse_state_.move_pattern) {
-        case 0:  // Horizontal movement
-            input.mi.dx = mouse_state_.direction_x * config_.distance;
-            input.mi.dy = 0;
-            break;
-        case 1:  // Vertical movement
-            input.mi.dx = 0;
-            input.mi.dy = mouse_state_.direction_y * config_.distance;
-            break;
-        case 2:  // Diagonal movement
-            input.mi.dx = mouse_state_.direction_x * config_.distance;
-            input.mi.dy = mouse_state_.direction_y * config_.distance;
-            break;
+    if (!reached) {
+        return 2;
     }
-    
-    // Boundary checks and direction changes
-    int screen_width = GetSystemMetrics(SM_CXSCREEN);
-    int screen_height = GetSystemMetrics(SM_CYSCREEN);
-    
-    if (current_pos.x + input.mi.dx < kScreenBorderMargin || 
-        current_pos.x + input.mi.dx > screen_width - kScreenBorderMargin) {
-        mouse_state_.direction_x = -mouse_state_.direction_x;
-        input.mi.dx = mouse_state_.direction_x * config_.distance;
+    return reply.compare(0, 2, "ok") == 0 ? 0 : 1;
+}
+
+std::string MouseMoverApp::OnControlRequest(void* context, const std::string& request) {
+    return static_cast<MouseMoverApp*>(context)->controller_.HandleControlRequest(request);
+}
+
+void MouseMoverApp::ShowStats() const {
+    char text[1024];
+    wchar_t wide[1024];
+    controller_.Statistics().Format(Reactor::Now(), text, sizeof(text));
+    MessageBoxW(hwnd_, Utf8ToWide(text, wide, sizeof(wide) / sizeof(wide[0])), L"Mouse Mover Statistics",
+                MB_OK | MB_ICONINFORMATION);
+    if (controller_.Current().footprint) {
+        TrimWorkingSet();
     }
+}
+
+void MouseMoverApp::ShowContextMenu() {
+    POINT pt;
+    GetCursorPos(&pt);
     
-    if (current_pos.y + input.mi.dy < kScreenBorderMargin || 
-        current_pos.y + input.mi.dy > screen_height - kScreenBorderMargin) {
-        mouse_state_.direction_y = -mouse_state_.direction_y;
-        input.mi.dy = mouse_state_.direction_y * config_.distance;
-    }
+    HMENU menu = CreatePopupMenu();
     
-    // Send the input
-    SendInput(1, &input, sizeof(INPUT));
+    // Pause/Resume
+    AppendMenuW(menu, MF_STRING, kMenuIdPause, controller_.IsPaused() ? L"Resume" : L"Pause");
+    if (controller_.Current().show_stats) {
+        AppendMenuW(menu, MF_STRING, kMenuIdStats, L"Statistics");
+    }
+    AppendMenu(menu, MF_SEPARATOR, 0, nullptr);
     
-    // Update last position after movement
-    GetCursorPos(&mouse_state_.last_user_pos);
+    AppendMenuW(menu, MF_STRING, kMenuIdExit, L"Exit");
     
-    // Cycle through movement patterns
-    mouse_state_.move_pattern = (mouse_state_.move_pattern + 1) % 3;
+    SetForegroundWindow(hwnd_);
+    TrackPopupMenu(menu, TPM_RIGHTBUTTON, pt.x, pt.y, 0, hwnd_, nullptr);
+    DestroyMenu(menu);
     
-    // Change directions occasionally for more natural movement
-    if (mouse_state_.move_pattern == 0) {
-        mouse_state_.direction_x = -mouse_state_.direction_x;
-        mouse_state_.direction_y = -mouse_state_.direction_y;
+    // The menu pulls in UI code the steady state never needs
+    if (controller_.Current().footprint) {
+        TrimWorkingSet();
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,398 @@
+#include "app_controller.h"
+#include "calibration.h"
+#include "clock.h"
+#include "config.h"
+#include "config_watcher.h"
+#include "control_server.h"
+#include "footprint.h"
+#include "mouse_engine.h"
+#include "power_source.h"
+#include "reactor.h"
+#include "session_monitor.h"
+#include "stats.h"
+#include "status_page.h"
+#include "trace.h"
+#include "x11_input_backend.h"
+#include "logind_power_request.h"
+#include <signal.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <string>
+
+namespace {
+// A realtime timer that never expires; TFD_TIMER_CANCEL_ON_SET makes it
+// readable with ECANCELED whenever the clock is set
+bool ArmClockWatch(int fd) {
+    itimerspec spec = {};
+    spec.it_value.tv_sec = std::numeric_limits<time_t>::max();
+    return timerfd_settime(fd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, nullptr) == 0;
+}
+
+// Seed of the move jitter: differs between sessions and between cloned
+// VMs that log on in the same instant
+uint64_t SessionSeed() {
+    timespec now = {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t seed = static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+    seed ^= (static_cast<uint64_t>(getsid(0)) << 32) ^ static_cast<uint64_t>(getpid());
+    
+    char name[256] = {};
+    if (gethostname(name, sizeof(name) - 1) == 0) {
+        for (const char* c = name; *c; ++c) {
+            seed = (seed ^ static_cast<unsigned char>(*c)) * 0x100000001b3ull;
+        }
+    }
+    return seed;
+}
+}
+
+// Linux front end. There is no tray: the process runs in the foreground
+// against $DISPLAY and is controlled with signals or the control socket.
+// What is not Linux-specific lives in AppController.
+class MouseMoverDaemon : private AppController::Host {
+public:
+    ~MouseMoverDaemon() override;
+    
+    int Run(int argc, char** argv);
+    
+private:
+    bool Initialize();
+    bool Start();
+    static void OnStartTimer(void* context);
+    static void OnConfigChanged(void* context);
+    bool CreateSignalHandler();
+    bool CreateClockWatch();
+    static void OnPowerSourceChanged(void* context);
+    static void OnClockChanged(void* context);
+    static int RunControlClient(const std::string& request);
+    static std::string OnControlRequest(void* context, const std::string& request);
+    static void OnSessionChanged(void* context);
+    void PrintStats() const;
+    static void OnSignal(void* context);
+    static void OnDisplayEvent(void* context);
+    
+    // AppController::Host
+    bool IsSessionActive() const override { return session_monitor_.IsActive(); }
+    bool IsSessionLocked() const override { return session_monitor_.IsLocked(); }
+    PowerSource CurrentPowerSource() const override { return power_source_.Current(); }
+    void SetTimerSlack(int percent) override { reactor_.SetTimerSlack(percent); }
+    void PublishStatus(StatusSnapshot& status, const Stats& stats, uint64_t now) override;
+    void OnPowerRequest(bool held) override;
+    void OnTicked() override;
+    void OnCalibrated(const CalibrationRecord& record) override;
+    void Report(const std::string& message) override;
+    
+    std::string cmd_line_;
+    X11InputBackend input_backend_;
+    int signal_fd_ = -1;
+    int clock_fd_ = -1;                 // becomes readable when the wall clock is set
+    int exit_code_ = 0;
+    
+    Reactor reactor_;
+    TimerWheel::Timer start_timer_{&MouseMoverDaemon::OnStartTimer, this};
+    ConfigWatcher config_watcher_;
+    ControlServer control_server_;
+    StatusPageWriter status_page_;
+    TraceRing trace_;
+    SystemClock clock_;
+    SessionMonitor session_monitor_;
+    PowerSourceMonitor power_source_;
+    AppController controller_{*this, reactor_.Timers(), clock_, trace_};
+    std::unique_ptr<MouseEngine> mouse_engine_;
+};
+
+int main(int argc, char** argv) {
+    MouseMoverDaemon daemon;
+    return daemon.Run(argc, argv);
+}
+
+MouseMoverDaemon::~MouseMoverDaemon() {
+    controller_.Stop();
+    if (signal_fd_ >= 0) {
+        close(signal_fd_);
+    }
+    if (clock_fd_ >= 0) {
+        close(clock_fd_);
+    }
+}
+
+int MouseMoverDaemon::Run(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        cmd_line_ += argv[i];
+        cmd_line_ += ' ';
+    }
+    
+    std::string request;
+    if (GetControlRequest(cmd_line_, request)) {
+        return RunControlClient(request);
+    }
+    
+    std::string error;
+    switch (controller_.Load(cmd_line_, error)) {
+        case ParseResult::kHelp:
+            std::puts(GetHelpText());
+            return 0;
+        case ParseResult::kError:
+            std::fprintf(stderr, "mm: %s\n", error.c_str());
+            return 1;
+        case ParseResult::kOk:
+            break;
+    }
+    
+    if (!Initialize()) {
+        return 1;
+    }
+    
+    reactor_.Run();
+    
+    if (controller_.Current().show_stats) {
+        PrintStats();
+    }
+    return exit_code_;
+}
+
+bool MouseMoverDaemon::Initialize() {
+    // First, so the rest of startup already runs at the low priority
+    const Config& config = controller_.Current();
+    if (config.efficiency) {
+        EnterEfficiencyMode();
+    }
+    
+    if (!reactor_.Initialize() || !CreateSignalHandler()) {
+        std::fprintf(stderr, "mm: Failed to initialize event loop\n");
+        return false;
+    }
+    
+    // The display connection, the watchers and the mover wait out the
+    // logon storm; only signals are handled until then
+    uint64_t delay = config.efficiency ? DeferredStartMs(config.start_delay, config.long_delay, SessionSeed()) : 0;
+    if (delay) {
+        reactor_.Timers().Schedule(start_timer_, Reactor::Now() + delay);
+        return true;
+    }
+    return Start();
+}
+
+bool MouseMoverDaemon::Start() {
+    std::string error;
+    if (!input_backend_.Initialize(nullptr, error)) {
+        std::fprintf(stderr, "mm: %s\n", error.c_str());
+        return false;
+    }
+    
+    if (!CreateClockWatch() ||
+        !reactor_.AddHandle(input_backend_.ConnectionFd(), &MouseMoverDaemon::OnDisplayEvent, this)) {
+        std::fprintf(stderr, "mm: Failed to initialize event loop\n");
+        return false;
+    }
+    
+    const Config& config = controller_.Current();
+    reactor_.SetTimerSlack(config.slack_percent);
+    
+    // Changes to the file are picked up without a restart; SIGHUP also reloads
+    if (!config_watcher_.Start(reactor_, config.config_path, &MouseMoverDaemon::OnConfigChanged, this)) {
+        std::fprintf(stderr, "mm: cannot watch %s for changes\n", config.config_path.c_str());
+    }
+    
+    // Runs without it: signals still work
+    if (!control_server_.Start(reactor_, &MouseMoverDaemon::OnControlRequest, this, error)) {
+        std::fprintf(stderr, "mm: no control socket: %s\n", error.c_str());
+    }
+    if (!status_page_.Open(error)) {
+        std::fprintf(stderr, "mm: no status page: %s\n", error.c_str());
+    }
+    
+    // Without logind the session counts as always in use
+    if (!session_monitor_.Start(reactor_, &MouseMoverDaemon::OnSessionChanged, this, error)) {
+        std::fprintf(stderr, "mm: no session tracking: %s\n", error.c_str());
+        if (config.calibrate) {
+            std::fprintf(stderr, "mm: --calibrate cannot see locks without it\n");
+        }
+    }
+    if (!power_source_.Start(reactor_, &MouseMoverDaemon::OnPowerSourceChanged, this, error)) {
+        std::fprintf(stderr, "mm: no power source tracking: %s\n", error.c_str());
+    }
+    
+    if (!config.trace_path.empty() && !trace_.MapFile(config.trace_path, error)) {
+        std::fprintf(stderr, "mm: tracing in memory: %s\n", error.c_str());
+    }
+    mouse_engine_ = std::make_unique<MouseEngine>(controller_.Configs(), input_backend_, clock_,
+                                                  controller_.Statistics(), &trace_);
+    mouse_engine_->SeedJitter(SessionSeed());
+    mouse_engine_->Calibration().Load(LoadCalibration());
+    
+    if (config.input_hooks) {
+        std::fprintf(stderr, "mm: --hooks is Windows only, using MIT-SCREEN-SAVER idle time\n");
+    }
+    std::unique_ptr<PowerRequest> power_request;
+    if (config.power_mode) {
+        // Connects once; Inhibit itself never waits for logind
+        auto logind_request = std::make_unique<LogindPowerRequest>();
+        if (logind_request->Start(reactor_, error)) {
+            power_request = std::move(logind_request);
+        } else {
+            std::fprintf(stderr, "mm: no power request: %s, moving the mouse instead\n", error.c_str());
+        }
+    }
+    controller_.Start(*mouse_engine_, std::move(power_request));
+    
+    // Everything touched so far was startup-only
+    if (config.footprint) {
+        ReduceFootprint();
+    }
+    return true;
+}
+
+void MouseMoverDaemon::OnStartTimer(void* context) {
+    auto* daemon = static_cast<MouseMoverDaemon*>(context);
+    if (!daemon->Start()) {
+        daemon->exit_code_ = 1;
+        daemon->reactor_.Stop();
+    }
+}
+
+void MouseMoverDaemon::OnConfigChanged(void* context) {
+    static_cast<MouseMoverDaemon*>(context)->controller_.ReloadConfig();
+}
+
+void MouseMoverDaemon::OnPowerSourceChanged(void* context) {
+    static_cast<MouseMoverDaemon*>(context)->controller_.UpdateEffectiveConfig();
+}
+
+bool MouseMoverDaemon::CreateClockWatch() {
+    // The reactor waits on the monotonic clock and would sleep through a
+    // wall clock jump over a schedule transition
+    clock_fd_ = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (clock_fd_ < 0 || !ArmClockWatch(clock_fd_)) {
+        return false;
+    }
+    return reactor_.AddHandle(clock_fd_, &MouseMoverDaemon::OnClockChanged, this);
+}
+
+void MouseMoverDaemon::OnClockChanged(void* context) {
+    auto* daemon = static_cast<MouseMoverDaemon*>(context);
+    
+    // The read fails with ECANCELED once per change; re-arming starts over
+    uint64_t expirations;
+    if (read(daemon->clock_fd_, &expirations, sizeof(expirations)) < 0 && errno != ECANCELED) {
+        return;
+    }
+    ArmClockWatch(daemon->clock_fd_);
+    
+    // localtime_r does not look at the time zone again by itself
+    tzset();
+    daemon->controller_.UpdateEffectiveConfig();
+}
+
+bool MouseMoverDaemon::CreateSignalHandler() {
+    // Signals are delivered through the reactor instead of async handlers
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGUSR1);
+    sigaddset(&mask, SIGUSR2);
+    sigaddset(&mask, SIGHUP);
+    if (sigprocmask(SIG_BLOCK, &mask, nullptr) != 0) {
+        return false;
+    }
+    
+    signal_fd_ = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd_ < 0) {
+        return false;
+    }
+    return reactor_.AddHandle(signal_fd_, &MouseMoverDaemon::OnSignal, this);
+}
+
+void MouseMoverDaemon::OnSessionChanged(void* context) {
+    static_cast<MouseMoverDaemon*>(context)->controller_.OnSessionChanged();
+}
+
+void MouseMoverDaemon::OnCalibrated(const CalibrationRecord& record) {
+    std::fprintf(stderr, "mm: lock timeout calibrated to %u s\n", record.timeout_seconds);
+    std::string error;
+    if (!SaveCalibration(record, error)) {
+        std::fprintf(stderr, "mm: %s\n", error.c_str());
+    }
+}
+
+void MouseMoverDaemon::Report(const std::string& message) {
+    std::fprintf(stderr, "mm: %s\n", message.c_str());
+}
+
+void MouseMoverDaemon::PublishStatus(StatusSnapshot& status, const Stats& stats, uint64_t now) {
+    status.pid = static_cast<uint64_t>(getpid());
+    status_page_.Publish(status, stats, now);
+}
+
+int MouseMoverDaemon::RunControlClient(const std::string& request) {
+    std::string reply;
+    std::string error;
+    if (!SendControlRequest(request, reply, error)) {
+        std::fprintf(stderr, "mm: %s\n", error.c_str());
+        return 2;
+    }
+    std::puts(reply.c_str());
+    return reply.compare(0, 2, "ok") == 0 ? 0 : 1;
+}
+
+std::string MouseMoverDaemon::OnControlRequest(void* context, const std::string& request) {
+    return static_cast<MouseMoverDaemon*>(context)->controller_.HandleControlRequest(request);
+}
+
+void MouseMoverDaemon::OnPowerRequest(bool held) {
+    // The logind inhibitor covers idle actions and sleep, the screen saver
+    // suspension covers X lockers
+    input_backend_.SuspendScreenSaver(held);
+}
+
+void MouseMoverDaemon::PrintStats() const {
+    char text[1024];
+    controller_.Statistics().Format(Reactor::Now(), text, sizeof(text));
+    std::fputs(text, stderr);
+}
+
+void MouseMoverDaemon::OnSignal(void* context) {
+    auto* daemon = static_cast<MouseMoverDaemon*>(context);
+    
+    signalfd_siginfo info;
+    while (read(daemon->signal_fd_, &info, sizeof(info)) == sizeof(info)) {
+        // Pause, statistics and reload are for the mover: a deferred start
+        // happens now rather than leave them unanswered
+        bool for_mover = info.ssi_signo == SIGUSR1 || info.ssi_signo == SIGUSR2 || info.ssi_signo == SIGHUP;
+        if (for_mover && daemon->start_timer_.IsArmed()) {
+            daemon->reactor_.Timers().Cancel(daemon->start_timer_);
+            OnStartTimer(daemon);
+            if (!daemon->controller_.IsStarted()) {
+                return;
+            }
+        }
+        
+        if (info.ssi_signo == SIGUSR1) {
+            daemon->controller_.TogglePause();
+        } else if (info.ssi_signo == SIGUSR2) {
+            daemon->PrintStats();
+        } else if (info.ssi_signo == SIGHUP) {
+            daemon->controller_.ReloadConfig();
+        } else {
+            daemon->reactor_.Stop();
+        }
+    }
+}
+
+void MouseMoverDaemon::OnDisplayEvent(void* context) {
+    auto* daemon = static_cast<MouseMoverDaemon*>(context);
+    daemon->input_backend_.ProcessEvents(true);
+}
+
+void MouseMoverDaemon::OnTicked() {
+    // Replies read during the tick may have queued a RandR event behind them
+    input_backend_.ProcessEvents(false);
+}
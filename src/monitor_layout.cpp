@@ -0,0 +1,39 @@
+#include "monitor_layout.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+// Squared distance from the point to the rectangle, 0 when inside
+int64_t DistanceSquared(const ScreenRect& rect, int x, int y) {
+    int64_t dx = x < rect.left ? rect.left - x : (x >= rect.right ? x - rect.right + 1 : 0);
+    int64_t dy = y < rect.top ? rect.top - y : (y >= rect.bottom ? y - rect.bottom + 1 : 0);
+    return dx * dx + dy * dy;
+}
+}
+
+void MonitorLayout::Assign(const ScreenRect* monitors, int count) {
+    count_ = std::min(count, kMaxMonitors);
+    std::copy(monitors, monitors + count_, monitors_);
+    std::sort(monitors_, monitors_ + count_, [](const ScreenRect& a, const ScreenRect& b) {
+        return a.left != b.left ? a.left < b.left : a.top < b.top;
+    });
+}
+
+const ScreenRect& MonitorLayout::Find(int x, int y) const {
+    // Only monitors starting at or left of x can contain it
+    const ScreenRect* end = std::upper_bound(monitors_, monitors_ + count_, x,
+        [](int value, const ScreenRect& rect) { return value < rect.left; });
+    for (const ScreenRect* rect = monitors_; rect != end; ++rect) {
+        if (x < rect->right && y >= rect->top && y < rect->bottom) {
+            return *rect;
+        }
+    }
+    
+    const ScreenRect* nearest = monitors_;
+    for (const ScreenRect* rect = monitors_ + 1; rect < monitors_ + count_; ++rect) {
+        if (DistanceSquared(*rect, x, y) < DistanceSquared(*nearest, x, y)) {
+            nearest = rect;
+        }
+    }
+    return *nearest;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "input_backend.h"
+
+// Cached monitor rectangles in desktop coordinates. Backends fill it when
+// the display configuration changes; per-tick lookups only read it. The
+// array is fixed-size and sorted by left edge, so lookups never allocate.
+class MonitorLayout {
+public:
+    static constexpr int kMaxMonitors = 16;
+    
+    // Replaces the layout; extra monitors beyond kMaxMonitors are dropped
+    void Assign(const ScreenRect* monitors, int count);
+    
+    int Count() const { return count_; }
+    const ScreenRect& Monitor(int index) const { return monitors_[index]; }
+    
+    // Monitor containing the point, or the nearest one when it falls in a
+    // gap between monitors. Must not be called on an empty layout.
+    const ScreenRect& Find(int x, int y) const;
+    
+private:
+    ScreenRect monitors_[kMaxMonitors];
+    int count_ = 0;
+};
@@ -0,0 +1,227 @@
+#include "mouse_engine.h"
+#include <cstdint>
+
+namespace {
+constexpr int kScreenBorderMargin = 10;
+
+// Auto mode re-reads the idle timeouts at least this often, so a changed
+// or newly enabled timeout is picked up before it can expire
+constexpr uint64_t kAutoRecheckMs = 5 * 60000;
+}
+
+MouseEngine::MouseEngine(const ConfigStore& config, InputBackend& backend, Clock& clock, Stats& stats,
+                         TraceRing* trace)
+    : config_(config), backend_(backend), clock_(clock), stats_(stats), trace_(trace) {
+    SeedJitter(0);
+}
+
+void MouseEngine::SeedJitter(uint64_t seed) {
+    random_.Seed(seed);
+    jitter_ = static_cast<uint32_t>(random_.Next() >> 32);
+}
+
+uint64_t MouseEngine::Tick(uint64_t now, uint64_t early_by) {
+    const Config& config = config_.Current();
+    now += early_by;
+    uint64_t idle = static_cast<uint64_t>(backend_.GetUserIdleTime().count()) + early_by;
+    uint64_t long_delay = static_cast<uint64_t>(config.long_delay) * 1000;
+    uint64_t short_delay = static_cast<uint64_t>(config.short_delay) * 1000;
+    uint64_t since_last_tick = now - last_tick_;
+    last_tick_ = now;
+    if (!has_ticked_) {
+        has_ticked_ = true;
+        first_tick_ = now;
+    }
+    last_user_input_ = now > idle ? now - idle : 0;
+    TraceRecord record = {};
+    
+    if (config.auto_mode) {
+        return AutoTick(config, now, idle, idle < since_last_tick);
+    }
+    
+    // User is active: sleep until the inactivity window ends exactly. The
+    // jitter stays below short_delay and so below long_delay.
+    uint64_t early = Early(config, short_delay);
+    if (idle + early < long_delay) {
+        bool user_input = idle < since_last_tick;
+        stats_.RecordSkip(user_input ? SkipReason::kUserActive : SkipReason::kLongDelay);
+        return Trace(record, user_input ? TraceEvent::kUserActive : TraceEvent::kLongDelay, now, idle,
+                     now + (long_delay - early - idle));
+    }
+    
+    // Early wakeup, the next move is not due yet. Measured from the last
+    // move with the current interval, so a reloaded short_delay applies at once.
+    if (has_moved_ && now < last_move_ + short_delay - early) {
+        return Trace(record, TraceEvent::kWaiting, now, idle, last_move_ + short_delay - early);
+    }
+    
+    // The first move keeps its phase even when the user was idle already
+    // at start, counted as if there had been a move then; otherwise
+    // instances started together on idle desktops would all move at once
+    if (!has_moved_ && config.jitter_percent && now < first_tick_ + short_delay - early) {
+        return Trace(record, TraceEvent::kWaiting, now, idle, first_tick_ + short_delay - early);
+    }
+    
+    // A move that did not reach the OS is traced as failed and retried
+    // an interval later, without counting as one
+    if (MoveMouse(config, record)) {
+        Moved(now);
+    }
+    return Trace(record, TraceEvent::kMoved, now, idle, now + short_delay - Early(config, short_delay));
+}
+
+uint64_t MouseEngine::AutoTick(const Config& config, uint64_t now, uint64_t idle, bool user_input) {
+    TraceRecord record = {};
+    uint64_t timeout = static_cast<uint64_t>(backend_.GetIdleTimeout().count());
+    bool calibrated = false;
+    if (config.calibrate && (!timeout || calibrator_.Timeout() < timeout)) {
+        timeout = calibrator_.Timeout();
+        calibrated = true;
+    }
+    // Rechecks are jittered as well, or instances would wake for them in step
+    uint64_t recheck = kAutoRecheckMs - Early(config, kAutoRecheckMs);
+    if (!timeout) {
+        return Trace(record, TraceEvent::kWaiting, now, idle, now + recheck);
+    }
+    
+    // Short timeouts keep at least half of each period between moves
+    uint64_t margin = static_cast<uint64_t>(config.auto_margin) * 1000;
+    uint64_t lead = timeout - (margin < timeout / 2 ? margin : timeout / 2);
+    
+    // The OS counts our moves as input, so the deadline runs from either
+    uint64_t last_input = has_moved_ && last_move_ > last_user_input_ ? last_move_ : last_user_input_;
+    uint64_t due = last_input + lead - Early(config, lead);
+    if (now < due) {
+        if (user_input) {
+            stats_.RecordSkip(SkipReason::kUserActive);
+        }
+        return Trace(record, user_input ? TraceEvent::kUserActive : TraceEvent::kWaiting, now, idle,
+                     due < now + recheck ? due : now + recheck);
+    }
+    
+    // The deadline still stands after a failed move, so it is retried
+    // after short_delay rather than a whole lead
+    if (!MoveMouse(config, record)) {
+        uint64_t retry = static_cast<uint64_t>(config.short_delay) * 1000;
+        return Trace(record, TraceEvent::kMoved, now, idle, now + (retry < recheck ? retry : recheck));
+    }
+    Moved(now);
+    if (calibrated) {
+        calibrator_.OnSurvived(clock_.WallTime());
+    }
+    uint64_t wait = lead - Early(config, lead);
+    recheck = kAutoRecheckMs - Early(config, kAutoRecheckMs);
+    return Trace(record, TraceEvent::kMoved, now, idle, now + (wait < recheck ? wait : recheck));
+}
+
+bool MouseEngine::OnSessionLocked(uint64_t now) {
+    const Config& config = config_.Current();
+    if (!config.auto_mode || !config.calibrate) {
+        return false;
+    }
+    uint64_t idle = static_cast<uint64_t>(backend_.GetUserIdleTime().count());
+    if (has_moved_ && now - last_move_ < idle) {
+        idle = now - last_move_;
+    }
+    return calibrator_.OnLocked(idle, clock_.WallTime());
+}
+
+void MouseEngine::Nudge(uint64_t now) {
+    TraceRecord record = {};
+    if (MoveMouse(config_.Current(), record)) {
+        Moved(now);
+    }
+    Trace(record, TraceEvent::kNudged, now, 0, 0);
+}
+
+void MouseEngine::Moved(uint64_t now) {
+    last_move_ = now;
+    has_moved_ = true;
+    jitter_ = static_cast<uint32_t>(random_.Next() >> 32);
+}
+
+uint64_t MouseEngine::Early(const Config& config, uint64_t interval) const {
+    if (!config.jitter_percent) {
+        return 0;
+    }
+    // Until the first move the jitter is the instance's phase
+    uint64_t bound = has_moved_ || config.auto_mode ? interval * config.jitter_percent / 100 : interval;
+    return (jitter_ * bound) >> 32;
+}
+
+uint64_t MouseEngine::Trace(TraceRecord& record, TraceEvent event, uint64_t now, uint64_t idle, uint64_t next) {
+    if (trace_) {
+        record.time = now;
+        record.next = next;
+        record.config_version = static_cast<uint32_t>(config_.Version());
+        record.idle_ms = idle < UINT32_MAX ? static_cast<uint32_t>(idle) : UINT32_MAX;
+        record.event = static_cast<uint8_t>(event);
+        trace_->Record(record);
+    }
+    return next;
+}
+
+bool MouseEngine::MoveMouse(const Config& config, TraceRecord& record) {
+    int x = 0;
+    int y = 0;
+    if (!backend_.GetCursorPosition(x, y)) {
+        // Nothing was injected; counted and traced as a failed injection
+        stats_.RecordInjection(false);
+        return false;
+    }
+    
+    // Calculate movement based on pattern
+    int dx = 0;
+    int dy = 0;
+    switch (move_pattern_) {
+        case 0:  // Horizontal movement
+            dx = direction_x_ * config.distance;
+            break;
+        case 1:  // Vertical movement
+            dy = direction_y_ * config.distance;
+            break;
+        case 2:  // Diagonal movement
+            dx = direction_x_ * config.distance;
+            dy = direction_y_ * config.distance;
+            break;
+    }
+    
+    // Boundary checks and direction changes
+    ScreenRect bounds = backend_.GetMonitorBounds(x, y);
+    
+    if (x + dx < bounds.left + kScreenBorderMargin ||
+        x + dx > bounds.right - kScreenBorderMargin) {
+        direction_x_ = -direction_x_;
+        dx = direction_x_ * config.distance;
+    }
+    
+    if (y + dy < bounds.top + kScreenBorderMargin ||
+        y + dy > bounds.bottom - kScreenBorderMargin) {
+        direction_y_ = -direction_y_;
+        dy = direction_y_ * config.distance;
+    }
+    
+    // A gesture returns to where the user left the cursor; a plain move drifts
+    bool injected = config.gesture ? backend_.NudgeCursor(x, y, dx, dy) : backend_.MoveCursorRelative(dx, dy);
+    stats_.RecordInjection(injected);
+    
+    record.x = x;
+    record.y = y;
+    record.dx = static_cast<int16_t>(dx);
+    record.dy = static_cast<int16_t>(dy);
+    record.result = injected;
+    record.bounds[0] = bounds.left;
+    record.bounds[1] = bounds.top;
+    record.bounds[2] = bounds.right;
+    record.bounds[3] = bounds.bottom;
+    
+    // Cycle through movement patterns
+    move_pattern_ = (move_pattern_ + 1) % 3;
+    
+    // Change directions occasionally for more natural movement
+    if (move_pattern_ == 0) {
+        direction_x_ = -direction_x_;
+        direction_y_ = -direction_y_;
+    }
+    return injected;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "calibration.h"
+#include "clock.h"
+#include "config_store.h"
+#include "input_backend.h"
+#include "random.h"
+#include "stats.h"
+#include "trace.h"
+#include <cstdint>
+
+// Platform-independent movement logic: decides when to move and where,
+// and talks to the OS only through the InputBackend and the Clock. Reads the current
+// config snapshot on every tick, so reloads apply from the next one.
+//
+// In auto mode the intervals give way to the OS idle timeout: one move a
+// margin before the earliest blank/lock/sleep deadline, counted from the
+// last input, whether the user's or ours. With calibration, a learned
+// or probed timeout takes part as well.
+//
+// With jitter_percent, every move comes a random share of up to that
+// percentage of its interval early, and the first one after start up to
+// a whole short_delay early, so instances started together drift apart.
+// That first phase also holds for a user who is idle already at start.
+// Moves only ever come earlier than without jitter, so no deadline the
+// plain schedule meets can slip.
+class MouseEngine {
+public:
+    // Each decision goes to `trace` if given
+    MouseEngine(const ConfigStore& config, InputBackend& backend, Clock& clock, Stats& stats,
+                TraceRing* trace = nullptr);
+    
+    // Runs one scheduling step at `now` (milliseconds on the reactor clock)
+    // and returns the instant the next step is due. `early_by` is how far
+    // ahead of its due time a coalesced timer fired; that time counts as
+    // already elapsed.
+    uint64_t Tick(uint64_t now, uint64_t early_by = 0);
+    
+    // Seeds the jitter; each session should use its own seed
+    void SeedJitter(uint64_t seed);
+    
+    // Moves once right away, whatever the user is doing; the next regular
+    // move is then a full interval later
+    void Nudge(uint64_t now);
+    
+    // Reactor times of the last move and of the last user input seen by a
+    // tick; 0 until there is one
+    uint64_t LastMove() const { return has_moved_ ? last_move_ : 0; }
+    uint64_t LastUserInput() const { return last_user_input_; }
+    
+    // The session locked at `now` while being kept awake; returns true if
+    // calibration learned a new timeout from it
+    bool OnSessionLocked(uint64_t now);
+    Calibrator& Calibration() { return calibrator_; }
+    
+private:
+    uint64_t AutoTick(const Config& config, uint64_t now, uint64_t idle, bool user_input);
+    // Returns false if no input reached the OS
+    bool MoveMouse(const Config& config, TraceRecord& record);
+    void Moved(uint64_t now);
+    
+    // How much earlier than due the pending move comes
+    uint64_t Early(const Config& config, uint64_t interval) const;
+    
+    // Completes and records a decision, returns `next`
+    uint64_t Trace(TraceRecord& record, TraceEvent event, uint64_t now, uint64_t idle, uint64_t next);
+    
+    const ConfigStore& config_;
+    InputBackend& backend_;
+    Clock& clock_;
+    Stats& stats_;
+    TraceRing* trace_;
+    
+    // Mouse movement state
+    int move_pattern_ = 0;  // 0=horizontal, 1=vertical, 2=diagonal
+    int direction_x_ = 1;
+    int direction_y_ = 1;
+    uint64_t last_move_ = 0;
+    bool has_moved_ = false;
+    uint64_t last_tick_ = 0;
+    uint64_t first_tick_ = 0;
+    bool has_ticked_ = false;
+    uint64_t last_user_input_ = 0;
+    Calibrator calibrator_;
+    Random random_;
+    uint32_t jitter_ = 0;   // share of the jitter bound for the pending move, in 1/2^32
+};
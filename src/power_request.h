@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+
+// Keeps the display awake and the session unlocked through OS power
+// management instead of synthetic input. Holding a request costs no
+// wakeups at all.
+class PowerRequest {
+public:
+    using FailedCallback = void (*)(void* context, const std::string& error);
+    
+    virtual ~PowerRequest() = default;
+    
+    // Takes the request. Fails, with a reason, when the OS refuses it or
+    // when something is known to defeat it, so callers can fall back to
+    // moving the mouse.
+    virtual bool Acquire(std::string& error) = 0;
+    virtual void Release() = 0;
+    
+    // Requests the OS answers later (logind) report a refusal after Acquire
+    // returned true through this, on the reactor thread. The callback may
+    // destroy the request.
+    void SetFailedCallback(FailedCallback callback, void* context) {
+        failed_callback_ = callback;
+        failed_context_ = context;
+    }
+    
+protected:
+    // Must be the last thing the caller does with this
+    void Fail(const std::string& error) {
+        if (failed_callback_) {
+            failed_callback_(failed_context_, error);
+        }
+    }
+    
+private:
+    FailedCallback failed_callback_ = nullptr;
+    void* failed_context_ = nullptr;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "config.h"
+#include "reactor.h"
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Tracks what the machine runs on and calls back on the reactor thread
+// when it changes, so a profile switch applies at once; nothing polls.
+//
+// Windows: RegisterPowerSettingNotification for GUID_ACDC_POWER_SOURCE and
+// GUID_POWER_SAVING_STATUS; the window procedure passes WM_POWERBROADCAST
+// on to OnPowerBroadcast().
+// Linux: power_supply uevents from a NETLINK_KOBJECT_UEVENT socket, each
+// followed by a read of /sys/class/power_supply (MM_POWER_SUPPLY_DIR
+// points it at another tree, e.g. a fake one for testing). There is no
+// battery saver flag in sysfs; a discharging battery at or below
+// kSaverCapacityPercent counts as one, as Windows' default does.
+class PowerSourceMonitor {
+public:
+    using Callback = void (*)(void* context);
+    
+    static constexpr int kSaverCapacityPercent = 20;
+    
+    PowerSourceMonitor() = default;
+    ~PowerSourceMonitor();
+    PowerSourceMonitor(const PowerSourceMonitor&) = delete;
+    PowerSourceMonitor& operator=(const PowerSourceMonitor&) = delete;
+    
+    // Without it the machine counts as on AC for good
+#ifdef _WIN32
+    bool Start(HWND window, Callback callback, void* context, std::string& error);
+    void OnPowerBroadcast(WPARAM event, LPARAM data);
+#else
+    bool Start(Reactor& reactor, Callback callback, void* context, std::string& error);
+    
+    // The source a power_supply class directory describes: AC if any mains
+    // or USB supply is online or there is no battery at all
+    static PowerSource ReadPowerSupplies(const std::string& directory);
+#endif
+    
+    PowerSource Current() const { return source_; }
+
+private:
+    void Update(PowerSource source) {
+        if (source != source_) {
+            source_ = source;
+            if (callback_) {
+                callback_(context_);
+            }
+        }
+    }
+    
+    Callback callback_ = nullptr;
+    void* context_ = nullptr;
+    PowerSource source_ = PowerSource::kAc;
+
+#ifdef _WIN32
+    PowerSource Combine() const;
+    
+    HPOWERNOTIFY source_notify_ = nullptr;
+    HPOWERNOTIFY saver_notify_ = nullptr;
+    bool on_battery_ = false;
+    bool saver_on_ = false;
+#else
+    static void OnUevent(void* context);
+    
+    Reactor* reactor_ = nullptr;
+    int uevent_fd_ = -1;
+    std::string directory_;
+#endif
+};
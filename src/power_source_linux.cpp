@@ -0,0 +1,140 @@
+#include "power_source.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+constexpr const char* kPowerSupplyDir = "/sys/class/power_supply";
+
+// First line of <supply>/<name>, empty if unreadable. Fixed buffers, so a
+// power source change does not allocate.
+const char* ReadAttribute(const char* supply, const char* name, char* value, size_t size) {
+    char path[PATH_MAX];
+    value[0] = '\0';
+    if (std::snprintf(path, sizeof(path), "%s/%s", supply, name) >= static_cast<int>(sizeof(path))) {
+        return value;
+    }
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return value;
+    }
+    ssize_t length = read(fd, value, size - 1);
+    close(fd);
+    value[length > 0 ? length : 0] = '\0';
+    value[std::strcspn(value, "\n")] = '\0';
+    return value;
+}
+
+// True if a NUL-separated uevent payload is about a power supply
+bool IsPowerSupplyEvent(const char* payload, size_t length) {
+    const char kSubsystem[] = "SUBSYSTEM=power_supply";
+    for (size_t offset = 0; offset < length; offset += std::strlen(payload + offset) + 1) {
+        if (std::strcmp(payload + offset, kSubsystem) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+PowerSourceMonitor::~PowerSourceMonitor() {
+    if (uevent_fd_ >= 0) {
+        reactor_->RemoveHandle(uevent_fd_);
+        close(uevent_fd_);
+    }
+}
+
+bool PowerSourceMonitor::Start(Reactor& reactor, Callback callback, void* context, std::string& error) {
+    reactor_ = &reactor;
+    const char* directory = std::getenv("MM_POWER_SUPPLY_DIR");
+    directory_ = directory && *directory ? directory : kPowerSupplyDir;
+    
+    // Kernel uevents (multicast group 1) need no privileges to receive
+    uevent_fd_ = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    sockaddr_nl address = {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = 1;
+    if (uevent_fd_ < 0 || bind(uevent_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        !reactor.AddHandle(uevent_fd_, &PowerSourceMonitor::OnUevent, this)) {
+        error = std::string("cannot listen for uevents: ") + std::strerror(errno);
+        if (uevent_fd_ >= 0) {
+            close(uevent_fd_);
+            uevent_fd_ = -1;
+        }
+        return false;
+    }
+    
+    Update(ReadPowerSupplies(directory_));
+    callback_ = callback;
+    context_ = context;
+    return true;
+}
+
+void PowerSourceMonitor::OnUevent(void* context) {
+    auto* monitor = static_cast<PowerSourceMonitor*>(context);
+    
+    // Other subsystems share the group; their events are read and dropped
+    char buffer[4096];
+    bool changed = false;
+    ssize_t length;
+    while ((length = recv(monitor->uevent_fd_, buffer, sizeof(buffer) - 1, 0)) > 0) {
+        buffer[length] = '\0';
+        changed |= IsPowerSupplyEvent(buffer, static_cast<size_t>(length));
+    }
+    
+    if (changed) {
+        monitor->Update(ReadPowerSupplies(monitor->directory_));
+    }
+}
+
+PowerSource PowerSourceMonitor::ReadPowerSupplies(const std::string& directory) {
+    DIR* supplies = opendir(directory.c_str());
+    if (!supplies) {
+        return PowerSource::kAc;
+    }
+    
+    bool has_battery = false;
+    int lowest_capacity = 100;
+    bool external_online = false;
+    while (dirent* entry = readdir(supplies)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char supply[PATH_MAX];
+        char value[64];
+        if (std::snprintf(supply, sizeof(supply), "%s/%s", directory.c_str(), entry->d_name) >=
+            static_cast<int>(sizeof(supply))) {
+            continue;
+        }
+        if (std::strcmp(ReadAttribute(supply, "type", value, sizeof(value)), "Battery") != 0) {
+            // Mains, USB and the like
+            external_online |= std::strcmp(ReadAttribute(supply, "online", value, sizeof(value)), "1") == 0;
+            continue;
+        }
+        
+        // Batteries of a wireless mouse or headset are not the machine's
+        if (std::strcmp(ReadAttribute(supply, "scope", value, sizeof(value)), "Device") == 0) {
+            continue;
+        }
+        has_battery = true;
+        char capacity[16];
+        if (ReadAttribute(supply, "capacity", capacity, sizeof(capacity))[0] &&
+            std::strcmp(ReadAttribute(supply, "status", value, sizeof(value)), "Discharging") == 0) {
+            int percent = std::atoi(capacity);
+            lowest_capacity = percent < lowest_capacity ? percent : lowest_capacity;
+        }
+    }
+    closedir(supplies);
+    
+    if (external_online || !has_battery) {
+        return PowerSource::kAc;
+    }
+    return lowest_capacity <= kSaverCapacityPercent ? PowerSource::kBatterySaver : PowerSource::kBattery;
+}
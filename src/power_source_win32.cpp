@@ -0,0 +1,65 @@
+#include "power_source.h"
+#include <cstring>
+
+namespace {
+// Defined here rather than through initguid.h
+const GUID kAcDcPowerSource = { 0x5d3e9a59, 0xe9d5, 0x4b00, { 0xa6, 0xbd, 0xff, 0x34, 0xff, 0x51, 0x65, 0x48 } };
+const GUID kPowerSavingStatus = { 0xe00958c0, 0xc213, 0x4ace, { 0xac, 0x77, 0xfe, 0xcc, 0xed, 0x2e, 0xee, 0xa5 } };
+}
+
+PowerSourceMonitor::~PowerSourceMonitor() {
+    if (source_notify_) {
+        UnregisterPowerSettingNotification(source_notify_);
+    }
+    if (saver_notify_) {
+        UnregisterPowerSettingNotification(saver_notify_);
+    }
+}
+
+bool PowerSourceMonitor::Start(HWND window, Callback callback, void* context, std::string& error) {
+    // Both send their current value right away as well
+    source_notify_ = RegisterPowerSettingNotification(window, &kAcDcPowerSource, DEVICE_NOTIFY_WINDOW_HANDLE);
+    if (!source_notify_) {
+        error = "RegisterPowerSettingNotification failed (" + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+    // Battery saver exists from Windows 10 on
+    saver_notify_ = RegisterPowerSettingNotification(window, &kPowerSavingStatus, DEVICE_NOTIFY_WINDOW_HANDLE);
+    
+    SYSTEM_POWER_STATUS status;
+    if (GetSystemPowerStatus(&status)) {
+        on_battery_ = status.ACLineStatus == 0;
+        saver_on_ = status.SystemStatusFlag == 1;
+    }
+    Update(Combine());
+    callback_ = callback;
+    context_ = context;
+    return true;
+}
+
+void PowerSourceMonitor::OnPowerBroadcast(WPARAM event, LPARAM data) {
+    if (event != PBT_POWERSETTINGCHANGE) {
+        return;
+    }
+    const auto* setting = reinterpret_cast<const POWERBROADCAST_SETTING*>(data);
+    if (setting->DataLength < sizeof(DWORD)) {
+        return;
+    }
+    DWORD value;
+    std::memcpy(&value, setting->Data, sizeof(value));
+    
+    // SYSTEM_POWER_CONDITION: PoAc, PoDc or PoHot (UPS); only DC is battery
+    if (IsEqualGUID(setting->PowerSetting, kAcDcPowerSource)) {
+        on_battery_ = value == PoDc;
+    } else if (IsEqualGUID(setting->PowerSetting, kPowerSavingStatus)) {
+        saver_on_ = value != 0;
+    }
+    Update(Combine());
+}
+
+PowerSource PowerSourceMonitor::Combine() const {
+    if (!on_battery_) {
+        return PowerSource::kAc;
+    }
+    return saver_on_ ? PowerSource::kBatterySaver : PowerSource::kBattery;
+}
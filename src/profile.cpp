@@ -0,0 +1,42 @@
+#include "profile.h"
+#include "config.h"
+#include <cstdio>
+#include <sstream>
+
+bool ParseProfileItem(const std::string& item, ConfigProfile& profile, std::string& error) {
+    std::string::size_type equals = item.find('=');
+    int value = 0;
+    char extra;
+    if (equals == std::string::npos || std::sscanf(item.c_str() + equals + 1, "%d%c", &value, &extra) != 1) {
+        error = "invalid profile setting '" + item + "'";
+        return false;
+    }
+    
+    std::string key = item.substr(0, equals);
+    if (key == "s" && value >= kMinDelaySeconds && value <= kMaxDelaySeconds) {
+        profile.short_delay = value;
+    } else if (key == "l" && value >= 0 && value <= kMaxLongDelaySeconds) {
+        profile.long_delay = value;
+    } else if (key == "d" && value >= kMinDistance && value <= kMaxDistance) {
+        profile.distance = value;
+    } else if (key == "slack" && value >= 0 && value <= kMaxSlackPercent) {
+        profile.slack_percent = value;
+    } else if (key == "gesture" && (value == 0 || value == 1)) {
+        profile.gesture = value;
+    } else {
+        error = "profile setting '" + item + "' is unknown or out of range";
+        return false;
+    }
+    return true;
+}
+
+bool ParseProfile(const std::string& items, ConfigProfile& profile, std::string& error) {
+    std::istringstream parts(items);
+    std::string item;
+    while (std::getline(parts, item, ',')) {
+        if (!ParseProfileItem(item, profile, error)) {
+            return false;
+        }
+    }
+    return true;
+}
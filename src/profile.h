@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+
+// Settings a schedule window or a power source profile applies on top of
+// the configuration; -1 keeps the configured value
+struct ConfigProfile {
+    int short_delay = -1;
+    int long_delay = -1;
+    int distance = -1;
+    int slack_percent = -1;
+    int gesture = -1;
+    
+    bool operator==(const ConfigProfile& other) const {
+        return short_delay == other.short_delay && long_delay == other.long_delay && distance == other.distance &&
+               slack_percent == other.slack_percent && gesture == other.gesture;
+    }
+    bool operator!=(const ConfigProfile& other) const { return !(*this == other); }
+};
+
+// Adds one "key=value" item: s, l, d (as -s, -l, -d), slack or gesture (0/1)
+bool ParseProfileItem(const std::string& item, ConfigProfile& profile, std::string& error);
+
+// Comma-separated items, e.g. "s=30,l=120,slack=20"
+bool ParseProfile(const std::string& items, ConfigProfile& profile, std::string& error);
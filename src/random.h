@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+// xoshiro256** (Blackman and Vigna): a few cycles per number and 32 bytes
+// of state. Not for anything secret; it only spreads timing.
+class Random {
+public:
+    explicit Random(uint64_t seed = 0) { Seed(seed); }
+    
+    // Expands the seed with splitmix64, so similar seeds give unrelated
+    // sequences and the state is never all zero
+    void Seed(uint64_t seed) {
+        for (uint64_t& word : state_) {
+            seed += 0x9e3779b97f4a7c15ull;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            word = z ^ (z >> 31);
+        }
+    }
+    
+    uint64_t Next() {
+        uint64_t result = Rotate(state_[1] * 5, 7) * 9;
+        uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = Rotate(state_[3], 45);
+        return result;
+    }
+    
+private:
+    static uint64_t Rotate(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+    
+    uint64_t state_[4];
+};
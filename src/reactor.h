@@ -0,0 +1,87 @@
+#pragma once
+
+#include "timer_wheel.h"
+#include <cstdint>
+
+// Single-threaded event loop. Waits on registered OS handles and the
+// timer wheel with one blocking call and dispatches callbacks inline.
+//
+// Windows: MsgWaitForMultipleObjectsEx over waitable objects plus the
+// thread's message queue, with a waitable timer for the wheel.
+// Linux: epoll over file descriptors, with a timerfd for the wheel.
+class Reactor {
+public:
+#ifdef _WIN32
+    using NativeHandle = void*;     // HANDLE
+#else
+    using NativeHandle = int;       // file descriptor
+#endif
+    using Callback = void (*)(void* context);
+
+    Reactor();
+    ~Reactor();
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    bool Initialize();
+
+    // Invokes the callback whenever the handle is signaled (Windows) or
+    // readable (Linux). The callback must reset or drain the handle.
+    bool AddHandle(NativeHandle handle, Callback callback, void* context);
+    void RemoveHandle(NativeHandle handle);
+
+    // Runs until Stop() is called or, on Windows, WM_QUIT is received
+    void Run();
+    void Stop();
+
+    TimerWheel& Timers() { return timers_; }
+    
+    // Lets the OS defer each timer wakeup by up to `percent` of the wait so
+    // it can coalesce with other wakeups. Timers then fire somewhere inside
+    // [expiry - window, expiry], never after their expiry.
+    void SetTimerSlack(int percent) { slack_percent_ = percent; }
+    
+    // Width of that early window for a wait from now until expiry
+    static uint64_t SlackWindow(uint64_t now, uint64_t expiry, int percent) {
+        return expiry > now ? (expiry - now) * static_cast<uint64_t>(percent) / 100 : 0;
+    }
+
+    // Milliseconds on the monotonic clock used by the timer wheel
+    static uint64_t Now();
+
+private:
+    // MsgWaitForMultipleObjectsEx takes MAXIMUM_WAIT_OBJECTS - 1 handles, one of which is the timer
+    static constexpr int kMaxHandles = 62;
+
+    struct Registration {
+        NativeHandle handle;
+        Callback callback;
+        void* context;
+    };
+
+    void ArmTimer();
+    void DispatchTimers();
+
+    TimerWheel timers_;
+    uint64_t armed_expiry_ = TimerWheel::kNever;
+    uint64_t fired_expiry_ = 0;     // expiry of the wakeup being dispatched, if the timer fired
+    int slack_percent_ = 0;
+    bool running_ = false;
+
+#ifdef _WIN32
+    bool PumpMessages();
+
+    NativeHandle timer_handle_ = nullptr;
+    NativeHandle wait_handles_[kMaxHandles + 1] = {};   // [0] is the timer
+    Registration registrations_[kMaxHandles] = {};
+    int registration_count_ = 0;
+#else
+    int WaitTimeout() const;
+    
+    int epoll_fd_ = -1;
+    int timer_fd_ = -1;
+    uint64_t window_start_ = TimerWheel::kNever;    // epoll timeout target when slack applies
+    uint64_t timer_slack_ns_ = 0;
+    Registration registrations_[kMaxHandles] = {};
+#endif
+};
@@ -0,0 +1,176 @@
+#include "reactor.h"
+#include <sys/epoll.h>
+#include <sys/prctl.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <ctime>
+
+namespace {
+constexpr int kMaxEventsPerWait = 16;
+}
+
+Reactor::Reactor() : timers_(Now()) {
+    for (Registration& registration : registrations_) {
+        registration = { -1, nullptr, nullptr };
+    }
+}
+
+Reactor::~Reactor() {
+    if (timer_fd_ >= 0) {
+        close(timer_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+bool Reactor::Initialize() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (epoll_fd_ < 0 || timer_fd_ < 0) {
+        return false;
+    }
+    
+    // A null data pointer marks the timer
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &event) == 0;
+}
+
+bool Reactor::AddHandle(NativeHandle handle, Callback callback, void* context) {
+    for (Registration& registration : registrations_) {
+        if (registration.callback) {
+            continue;
+        }
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = &registration;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, handle, &event) != 0) {
+            return false;
+        }
+        registration = { handle, callback, context };
+        return true;
+    }
+    return false;
+}
+
+void Reactor::RemoveHandle(NativeHandle handle) {
+    for (Registration& registration : registrations_) {
+        if (registration.callback && registration.handle == handle) {
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, handle, nullptr);
+            registration = { -1, nullptr, nullptr };
+            return;
+        }
+    }
+}
+
+void Reactor::Run() {
+    running_ = true;
+    
+    while (running_) {
+        ArmTimer();
+        
+        epoll_event events[kMaxEventsPerWait];
+        int count = epoll_wait(epoll_fd_, events, kMaxEventsPerWait, WaitTimeout());
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        
+        // The slack window elapsed: treat it as the timer firing. The timerfd
+        // stays armed until the next ArmTimer moves it.
+        if (count == 0) {
+            fired_expiry_ = armed_expiry_;
+            window_start_ = TimerWheel::kNever;
+        }
+        
+        for (int i = 0; i < count; ++i) {
+            auto* registration = static_cast<Registration*>(events[i].data.ptr);
+            if (!registration) {
+                uint64_t expirations;
+                ssize_t ignored = read(timer_fd_, &expirations, sizeof(expirations));
+                (void)ignored;
+                fired_expiry_ = armed_expiry_;
+                armed_expiry_ = TimerWheel::kNever;
+                window_start_ = TimerWheel::kNever;
+            } else if (registration->callback) {
+                // An earlier callback in this batch may have removed it
+                registration->callback(registration->context);
+            }
+        }
+        
+        DispatchTimers();
+    }
+    
+    running_ = false;
+}
+
+void Reactor::Stop() {
+    running_ = false;
+}
+
+uint64_t Reactor::Now() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000 + static_cast<uint64_t>(now.tv_nsec) / 1000000;
+}
+
+void Reactor::ArmTimer() {
+    uint64_t expiry = timers_.NextExpiry();
+    if (expiry == armed_expiry_) {
+        return;
+    }
+    armed_expiry_ = expiry;
+    
+    // The timerfd holds the hard deadline. With slack, epoll_wait times out
+    // at the start of the window instead; its timeout honours the thread's
+    // timer slack, so the kernel may push the wakeup up to the expiry.
+    window_start_ = TimerWheel::kNever;
+    if (slack_percent_ > 0 && expiry != TimerWheel::kNever) {
+        uint64_t window = SlackWindow(Now(), expiry, slack_percent_);
+        uint64_t slack_ns = window * 1000000;
+        if (slack_ns != timer_slack_ns_ && slack_ns) {
+            prctl(PR_SET_TIMERSLACK, static_cast<unsigned long>(slack_ns), 0, 0, 0);
+            timer_slack_ns_ = slack_ns;
+        }
+        if (window) {
+            window_start_ = expiry - window;
+        }
+    }
+    
+    // An all-zero value disarms the timer
+    itimerspec spec = {};
+    if (expiry != TimerWheel::kNever) {
+        spec.it_value.tv_sec = static_cast<time_t>(expiry / 1000);
+        spec.it_value.tv_nsec = static_cast<long>((expiry % 1000) * 1000000);
+    }
+    timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+int Reactor::WaitTimeout() const {
+    if (window_start_ == TimerWheel::kNever) {
+        return -1;
+    }
+    uint64_t now = Now();
+    if (window_start_ <= now) {
+        return 0;
+    }
+    uint64_t timeout = window_start_ - now;
+    return timeout < INT_MAX ? static_cast<int>(timeout) : INT_MAX;
+}
+
+void Reactor::DispatchTimers() {
+    // A coalesced wakeup lands inside the slack window; everything up to
+    // the expiry it was armed for is due
+    uint64_t now = Now();
+    if (fired_expiry_ > now) {
+        now = fired_expiry_;
+    }
+    fired_expiry_ = 0;
+    timers_.Advance(now);
+}
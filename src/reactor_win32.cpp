@@ -0,0 +1,130 @@
+#include "reactor.h"
+#include <windows.h>
+#include <chrono>
+
+Reactor::Reactor() : timers_(Now()) {
+}
+
+Reactor::~Reactor() {
+    if (timer_handle_) {
+        CloseHandle(timer_handle_);
+    }
+}
+
+bool Reactor::Initialize() {
+    // Auto-reset timer, so a fired timer does not stay signaled
+    timer_handle_ = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    if (!timer_handle_) {
+        return false;
+    }
+    wait_handles_[0] = timer_handle_;
+    return true;
+}
+
+bool Reactor::AddHandle(NativeHandle handle, Callback callback, void* context) {
+    if (registration_count_ >= kMaxHandles) {
+        return false;
+    }
+    registrations_[registration_count_] = { handle, callback, context };
+    wait_handles_[registration_count_ + 1] = handle;
+    ++registration_count_;
+    return true;
+}
+
+void Reactor::RemoveHandle(NativeHandle handle) {
+    for (int i = 0; i < registration_count_; ++i) {
+        if (registrations_[i].handle != handle) {
+            continue;
+        }
+        // Keep the wait array dense
+        for (int j = i + 1; j < registration_count_; ++j) {
+            registrations_[j - 1] = registrations_[j];
+            wait_handles_[j] = wait_handles_[j + 1];
+        }
+        --registration_count_;
+        return;
+    }
+}
+
+void Reactor::Run() {
+    running_ = true;
+    
+    while (running_) {
+        ArmTimer();
+        
+        DWORD count = static_cast<DWORD>(registration_count_ + 1);
+        DWORD result = MsgWaitForMultipleObjectsEx(count, wait_handles_, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+        
+        if (result == WAIT_OBJECT_0) {
+            fired_expiry_ = armed_expiry_;
+            armed_expiry_ = TimerWheel::kNever;
+        } else if (result > WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + count) {
+            Registration& registration = registrations_[result - WAIT_OBJECT_0 - 1];
+            registration.callback(registration.context);
+        } else if (result == WAIT_OBJECT_0 + count) {
+            if (!PumpMessages()) {
+                break;
+            }
+        } else {
+            break;
+        }
+        
+        DispatchTimers();
+    }
+    
+    running_ = false;
+}
+
+void Reactor::Stop() {
+    running_ = false;
+}
+
+uint64_t Reactor::Now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Reactor::ArmTimer() {
+    uint64_t expiry = timers_.NextExpiry();
+    if (expiry == armed_expiry_) {
+        return;
+    }
+    armed_expiry_ = expiry;
+    
+    if (expiry == TimerWheel::kNever) {
+        CancelWaitableTimer(timer_handle_);
+        return;
+    }
+    
+    // Due at the start of the slack window; the tolerable delay lets the
+    // kernel push it to any point up to the expiry to batch wakeups.
+    // Negative due times are relative, in 100 ns units.
+    uint64_t now = Now();
+    uint64_t window = SlackWindow(now, expiry, slack_percent_);
+    LARGE_INTEGER due;
+    due.QuadPart = expiry > now ? -static_cast<LONGLONG>((expiry - window - now) * 10000) : -1;
+    SetWaitableTimerEx(timer_handle_, &due, 0, nullptr, nullptr, nullptr, static_cast<ULONG>(window));
+}
+
+void Reactor::DispatchTimers() {
+    // A coalesced wakeup lands inside the slack window; everything up to
+    // the expiry it was armed for is due
+    uint64_t now = Now();
+    if (fired_expiry_ > now) {
+        now = fired_expiry_;
+    }
+    fired_expiry_ = 0;
+    timers_.Advance(now);
+}
+
+bool Reactor::PumpMessages() {
+    MSG msg;
+    while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+        if (msg.message == WM_QUIT) {
+            return false;
+        }
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+    return true;
+}
@@ -0,0 +1,203 @@
+#include "schedule.h"
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+
+namespace {
+constexpr int kMinutesPerDay = 24 * 60;
+constexpr const char* kDayNames[] = { "mon", "tue", "wed", "thu", "fri", "sat", "sun" };
+
+int DayIndex(const std::string& name) {
+    for (int i = 0; i < 7; ++i) {
+        if (name == kDayNames[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Bit i set for each day i (Monday = 0) named in DAYS
+bool ParseDays(const std::string& text, unsigned& days) {
+    days = 0;
+    if (text == "daily") {
+        days = 0x7f;
+        return true;
+    }
+    std::istringstream parts(text);
+    std::string part;
+    while (std::getline(parts, part, '+')) {
+        std::string::size_type dash = part.find('-');
+        int first = DayIndex(part.substr(0, dash));
+        int last = dash == std::string::npos ? first : DayIndex(part.substr(dash + 1));
+        if (first < 0 || last < 0) {
+            return false;
+        }
+        // mon-fri, or a range that wraps such as fri-mon
+        for (int day = first;; day = (day + 1) % 7) {
+            days |= 1u << day;
+            if (day == last) {
+                break;
+            }
+        }
+    }
+    return days != 0;
+}
+
+bool ParseClock(const std::string& text, int& minutes) {
+    int hours = 0;
+    int mins = 0;
+    char extra;
+    if (std::sscanf(text.c_str(), "%d:%d%c", &hours, &mins, &extra) != 2 ||
+        hours < 0 || hours > 24 || mins < 0 || mins > 59 || (hours == 24 && mins != 0)) {
+        return false;
+    }
+    minutes = hours * 60 + mins;
+    return true;
+}
+}
+
+bool Schedule::Add(const std::string& spec, std::string& error) {
+    std::string::size_type at = spec.find('@');
+    std::string::size_type comma = spec.find(',');
+    std::string::size_type dash = spec.find('-', at);
+    if (at == std::string::npos || dash == std::string::npos || (comma != std::string::npos && comma < dash)) {
+        error = "schedule must look like mon-fri@08:00-18:00, not '" + spec + "'";
+        return false;
+    }
+    
+    unsigned days = 0;
+    int start = 0;
+    int end = 0;
+    if (!ParseDays(spec.substr(0, at), days)) {
+        error = "invalid schedule days in '" + spec + "'";
+        return false;
+    }
+    std::string times_end = spec.substr(dash + 1, comma == std::string::npos ? std::string::npos : comma - dash - 1);
+    if (!ParseClock(spec.substr(at + 1, dash - at - 1), start) || !ParseClock(times_end, end) ||
+        start == kMinutesPerDay) {
+        error = "invalid schedule times in '" + spec + "'";
+        return false;
+    }
+    if (end <= start) {
+        end += kMinutesPerDay;
+    }
+    
+    ScheduleInterval interval;
+    if (comma != std::string::npos && !ParseProfile(spec.substr(comma + 1), interval.profile, error)) {
+        return false;
+    }
+    
+    for (int day = 0; day < 7; ++day) {
+        if (!(days & (1u << day))) {
+            continue;
+        }
+        interval.start = day * kMinutesPerDay + start;
+        interval.end = day * kMinutesPerDay + end;
+        
+        // Sunday night into Monday morning wraps to the start of the week
+        if (interval.end > kMinutesPerWeek) {
+            ScheduleInterval wrapped = interval;
+            wrapped.start = 0;
+            wrapped.end = interval.end - kMinutesPerWeek;
+            interval.end = kMinutesPerWeek;
+            if (!Insert(wrapped, error)) {
+                return false;
+            }
+        }
+        if (!Insert(interval, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Schedule::Insert(const ScheduleInterval& interval, std::string& error) {
+    if (count_ == kMaxIntervals) {
+        error = "too many schedule intervals";
+        return false;
+    }
+    
+    // Sorted insert; touching windows are fine, overlapping ones are not
+    int position = count_;
+    while (position > 0 && intervals_[position - 1].start > interval.start) {
+        --position;
+    }
+    if ((position > 0 && intervals_[position - 1].end > interval.start) ||
+        (position < count_ && interval.end > intervals_[position].start)) {
+        error = "schedule windows overlap";
+        return false;
+    }
+    for (int i = count_; i > position; --i) {
+        intervals_[i] = intervals_[i - 1];
+    }
+    intervals_[position] = interval;
+    ++count_;
+    return true;
+}
+
+int Schedule::ActiveUntil(int index) const {
+    // Touching windows with the same settings are one window, including a
+    // Sunday night window that was split at the week boundary
+    const ScheduleInterval& active = intervals_[index];
+    int end = active.end;
+    for (int step = 1; step < count_ + 1; ++step) {
+        int next = (index + step) % count_;
+        int offset = index + step >= count_ ? kMinutesPerWeek : 0;
+        const ScheduleInterval& interval = intervals_[next];
+        if (interval.start + offset != end || interval.profile != active.profile) {
+            return end;
+        }
+        if (next == index) {
+            return -1;      // active around the clock
+        }
+        end = interval.end + offset;
+    }
+    return end;
+}
+
+Schedule::State Schedule::Evaluate(std::chrono::system_clock::time_point now) const {
+    State state;
+    if (!count_) {
+        return state;
+    }
+    
+    std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    std::tm local;
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    int minute = ((local.tm_wday + 6) % 7) * kMinutesPerDay + local.tm_hour * 60 + local.tm_min;
+    
+    // The window containing now, or the first one after it (wrapping to next week)
+    int next_change = intervals_[0].start + kMinutesPerWeek;
+    state.active = false;
+    for (int i = 0; i < count_; ++i) {
+        if (minute < intervals_[i].start) {
+            next_change = intervals_[i].start;
+            break;
+        }
+        if (minute < intervals_[i].end) {
+            state.active = true;
+            state.interval = &intervals_[i];
+            next_change = ActiveUntil(i);
+            break;
+        }
+    }
+    if (next_change < 0) {
+        return state;
+    }
+    
+    // Let mktime place the transition in local time, across DST if need be
+    std::tm target = local;
+    target.tm_min += next_change - minute;
+    target.tm_sec = 0;
+    target.tm_isdst = -1;
+    std::time_t change = std::mktime(&target);
+    
+    auto until = std::chrono::system_clock::from_time_t(change) - now;
+    long long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(until).count();
+    state.next_change_ms = milliseconds > 0 ? static_cast<uint64_t>(milliseconds) : 1000;
+    return state;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "profile.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// One active window in local time, as minutes since Monday 00:00. Windows
+// that cross midnight into Monday are split, so end never exceeds a week.
+struct ScheduleInterval {
+    int start = 0;
+    int end = 0;            // exclusive
+    ConfigProfile profile;  // applied while inside
+};
+
+// Weekly working-hours profile, compiled into a sorted table of disjoint
+// intervals. An empty schedule means always active. Fixed capacity, so the
+// Config holding it stays a flat copyable value.
+class Schedule {
+public:
+    static constexpr int kMaxIntervals = 32;
+    static constexpr int kMinutesPerWeek = 7 * 24 * 60;
+    
+    // Adds "DAYS@HH:MM-HH:MM[,PROFILE]", see ParseProfile. DAYS is a day
+    // (mon..sun), a range such as mon-fri, days joined with '+', or daily.
+    // An end at or before the start runs past midnight.
+    bool Add(const std::string& spec, std::string& error);
+    void Clear() { count_ = 0; }
+    
+    bool IsEmpty() const { return count_ == 0; }
+    
+    struct State {
+        bool active = true;
+        const ScheduleInterval* interval = nullptr;     // active window, if any
+        uint64_t next_change_ms = 0;    // until the next transition; 0 if there is none
+    };
+    
+    // Where the given moment falls, in the local time zone. The next
+    // transition is found through mktime, so a DST change in between is
+    // accounted for.
+    State Evaluate(std::chrono::system_clock::time_point now) const;
+
+private:
+    bool Insert(const ScheduleInterval& interval, std::string& error);
+    int ActiveUntil(int index) const;
+    
+    ScheduleInterval intervals_[kMaxIntervals];
+    int count_ = 0;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "reactor.h"
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+struct DBusConnection;
+struct DBusMessage;
+#endif
+
+// Tracks whether the session we run in is in use: connected, in the
+// foreground and not locked. Calls back on the reactor thread when that
+// changes, so the front end can park the scheduler for as long as nobody
+// can see the screen.
+//
+// Windows: WTSRegisterSessionNotification; the window procedure passes
+// WM_WTSSESSION_CHANGE on to OnSessionChange().
+// Linux: PropertiesChanged on the logind session object (Active for
+// console switches, LockedHint for screen lockers), over a private system
+// bus connection whose socket is registered with the reactor. The
+// properties are read back with an asynchronous GetAll, so the reactor
+// never waits on logind once running.
+class SessionMonitor {
+public:
+    using Callback = void (*)(void* context);
+    
+    SessionMonitor() = default;
+    ~SessionMonitor();
+    SessionMonitor(const SessionMonitor&) = delete;
+    SessionMonitor& operator=(const SessionMonitor&) = delete;
+    
+    // Without it the session counts as active for good
+#ifdef _WIN32
+    bool Start(HWND window, Callback callback, void* context, std::string& error);
+    void OnSessionChange(WPARAM event);
+#else
+    bool Start(Reactor& reactor, Callback callback, void* context, std::string& error);
+#endif
+    
+    bool IsActive() const { return connected_ && !locked_; }
+    bool IsLocked() const { return locked_; }
+
+private:
+    void Update(bool connected, bool locked) {
+        bool was_active = IsActive();
+        connected_ = connected;
+        locked_ = locked;
+        if (IsActive() != was_active && callback_) {
+            callback_(context_);
+        }
+    }
+    
+    Callback callback_ = nullptr;
+    void* context_ = nullptr;
+    bool connected_ = true;
+    bool locked_ = false;
+
+#ifdef _WIN32
+    static bool IsConnected();
+    static bool QueryLocked();
+    
+    HWND window_ = nullptr;
+#else
+    static void OnBusEvent(void* context);
+    void ProcessMessages();
+    void RequestRefresh();
+    void Apply(DBusMessage* properties);
+    
+    Reactor* reactor_ = nullptr;
+    DBusConnection* connection_ = nullptr;
+    int bus_fd_ = -1;
+    uint32_t refresh_serial_ = 0;   // of the GetAll in flight, 0 if none
+    std::string session_path_;
+#endif
+};
@@ -0,0 +1,201 @@
+#include "session_monitor.h"
+#include <dbus/dbus.h>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+constexpr int kCallTimeoutMs = 5000;
+constexpr const char* kLogind = "org.freedesktop.login1";
+constexpr const char* kSessionInterface = "org.freedesktop.login1.Session";
+constexpr const char* kPropertiesInterface = "org.freedesktop.DBus.Properties";
+
+// Properties.GetAll for the session's interface, or null
+DBusMessage* NewGetAll(const std::string& path) {
+    DBusMessage* call = dbus_message_new_method_call(kLogind, path.c_str(), kPropertiesInterface, "GetAll");
+    const char* interface = kSessionInterface;
+    if (call && !dbus_message_append_args(call, DBUS_TYPE_STRING, &interface, DBUS_TYPE_INVALID)) {
+        dbus_message_unref(call);
+        return nullptr;
+    }
+    return call;
+}
+
+// Picks Active and LockedHint out of a GetAll reply; leaves either alone
+// if it is missing
+void ReadSessionProperties(DBusMessage* reply, bool& active, bool& locked) {
+    DBusMessageIter iter;
+    DBusMessageIter entries;
+    if (!dbus_message_iter_init(reply, &iter) || dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_ARRAY) {
+        return;
+    }
+    dbus_message_iter_recurse(&iter, &entries);
+    for (; dbus_message_iter_get_arg_type(&entries) == DBUS_TYPE_DICT_ENTRY; dbus_message_iter_next(&entries)) {
+        DBusMessageIter entry;
+        DBusMessageIter variant;
+        const char* name = nullptr;
+        dbus_message_iter_recurse(&entries, &entry);
+        if (dbus_message_iter_get_arg_type(&entry) != DBUS_TYPE_STRING) {
+            continue;
+        }
+        dbus_message_iter_get_basic(&entry, &name);
+        if (!dbus_message_iter_next(&entry) || dbus_message_iter_get_arg_type(&entry) != DBUS_TYPE_VARIANT) {
+            continue;
+        }
+        dbus_message_iter_recurse(&entry, &variant);
+        if (dbus_message_iter_get_arg_type(&variant) != DBUS_TYPE_BOOLEAN) {
+            continue;
+        }
+        dbus_bool_t value = FALSE;
+        dbus_message_iter_get_basic(&variant, &value);
+        if (std::strcmp(name, "Active") == 0) {
+            active = value;
+        } else if (std::strcmp(name, "LockedHint") == 0) {
+            locked = value;
+        }
+    }
+}
+}
+
+SessionMonitor::~SessionMonitor() {
+    if (connection_) {
+        if (bus_fd_ >= 0) {
+            reactor_->RemoveHandle(bus_fd_);
+        }
+        dbus_connection_close(connection_);
+        dbus_connection_unref(connection_);
+    }
+}
+
+bool SessionMonitor::Start(Reactor& reactor, Callback callback, void* context, std::string& error) {
+    reactor_ = &reactor;
+    
+    DBusError bus_error;
+    dbus_error_init(&bus_error);
+    connection_ = dbus_bus_get_private(DBUS_BUS_SYSTEM, &bus_error);
+    if (!connection_) {
+        error = std::string("Cannot connect to the system bus: ") + bus_error.message;
+        dbus_error_free(&bus_error);
+        return false;
+    }
+    dbus_connection_set_exit_on_disconnect(connection_, FALSE);
+    
+    // XDG_SESSION_ID from pam_systemd, else whatever logind picks for us
+    const char* session_id = std::getenv("XDG_SESSION_ID");
+    if (!session_id || !*session_id) {
+        session_id = "auto";
+    }
+    DBusMessage* call = dbus_message_new_method_call(kLogind, "/org/freedesktop/login1",
+                                                     "org.freedesktop.login1.Manager", "GetSession");
+    DBusMessage* reply = nullptr;
+    if (call && dbus_message_append_args(call, DBUS_TYPE_STRING, &session_id, DBUS_TYPE_INVALID)) {
+        reply = dbus_connection_send_with_reply_and_block(connection_, call, kCallTimeoutMs, &bus_error);
+    }
+    const char* path = nullptr;
+    if (reply && dbus_message_get_args(reply, &bus_error, DBUS_TYPE_OBJECT_PATH, &path, DBUS_TYPE_INVALID)) {
+        session_path_ = path;
+    }
+    if (reply) {
+        dbus_message_unref(reply);
+    }
+    if (call) {
+        dbus_message_unref(call);
+    }
+    
+    // Only our session's property changes; everything else stays on the bus
+    if (!session_path_.empty()) {
+        std::string rule = "type='signal',sender='org.freedesktop.login1',"
+                           "interface='org.freedesktop.DBus.Properties',member='PropertiesChanged',"
+                           "path='" + session_path_ + "'";
+        dbus_bus_add_match(connection_, rule.c_str(), &bus_error);
+    }
+    
+    int fd = -1;
+    if (session_path_.empty() || dbus_error_is_set(&bus_error) || !dbus_connection_get_unix_fd(connection_, &fd) ||
+        !reactor.AddHandle(fd, &SessionMonitor::OnBusEvent, this)) {
+        error = std::string("no logind session: ") +
+                (dbus_error_is_set(&bus_error) ? bus_error.message : "cannot watch the bus");
+        dbus_error_free(&bus_error);
+        dbus_connection_close(connection_);
+        dbus_connection_unref(connection_);
+        connection_ = nullptr;
+        return false;
+    }
+    bus_fd_ = fd;
+    
+    // The first read blocks, as the rest of startup does. The match is in
+    // place already, so a change racing with it is queued as a signal.
+    if (DBusMessage* get_all = NewGetAll(session_path_)) {
+        DBusMessage* reply = dbus_connection_send_with_reply_and_block(connection_, get_all, kCallTimeoutMs, nullptr);
+        if (reply) {
+            Apply(reply);
+            dbus_message_unref(reply);
+        }
+        dbus_message_unref(get_all);
+    }
+    callback_ = callback;
+    context_ = context;
+    
+    // What the blocking calls left queued will not make the socket readable
+    // again
+    ProcessMessages();
+    return true;
+}
+
+void SessionMonitor::OnBusEvent(void* context) {
+    auto* monitor = static_cast<SessionMonitor*>(context);
+    monitor->ProcessMessages();
+    
+    // A lost bus means no more updates: fall back to active
+    if (!dbus_connection_get_is_connected(monitor->connection_)) {
+        monitor->reactor_->RemoveHandle(monitor->bus_fd_);
+        monitor->bus_fd_ = -1;
+        monitor->Update(true, false);
+    }
+}
+
+void SessionMonitor::ProcessMessages() {
+    // Everything readable goes into libdbus's queue, and the queue is
+    // emptied here: a message left in it would not wake the reactor again
+    dbus_connection_read_write(connection_, 0);
+    bool changed = false;
+    while (DBusMessage* message = dbus_connection_pop_message(connection_)) {
+        if (dbus_message_is_signal(message, kPropertiesInterface, "PropertiesChanged")) {
+            changed = true;
+        } else if (refresh_serial_ && dbus_message_get_reply_serial(message) == refresh_serial_) {
+            refresh_serial_ = 0;
+            if (dbus_message_get_type(message) == DBUS_MESSAGE_TYPE_METHOD_RETURN) {
+                Apply(message);
+            }
+        }
+        dbus_message_unref(message);
+    }
+    
+    // Signals only say that something changed; the properties are read back
+    if (changed && dbus_connection_get_is_connected(connection_)) {
+        RequestRefresh();
+    }
+}
+
+void SessionMonitor::RequestRefresh() {
+    // Never waits for logind: the reply comes back through ProcessMessages.
+    // Only the latest request's reply counts, as it saw the latest change.
+    DBusMessage* call = NewGetAll(session_path_);
+    if (!call) {
+        return;
+    }
+    dbus_uint32_t serial = 0;
+    if (dbus_connection_send(connection_, call, &serial)) {
+        refresh_serial_ = serial;
+        dbus_connection_flush(connection_);
+    }
+    dbus_message_unref(call);
+}
+
+void SessionMonitor::Apply(DBusMessage* properties) {
+    // Active is false while another session owns the seat (console switch);
+    // LockedHint is set by screen lockers that talk to logind
+    bool active = connected_;
+    bool locked = locked_;
+    ReadSessionProperties(properties, active, locked);
+    Update(active, locked);
+}
@@ -0,0 +1,65 @@
+#include "session_monitor.h"
+#include <wtsapi32.h>
+
+SessionMonitor::~SessionMonitor() {
+    if (window_) {
+        WTSUnRegisterSessionNotification(window_);
+    }
+}
+
+bool SessionMonitor::Start(HWND window, Callback callback, void* context, std::string& error) {
+    if (!WTSRegisterSessionNotification(window, NOTIFY_FOR_THIS_SESSION)) {
+        error = "WTSRegisterSessionNotification failed (" + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+    window_ = window;
+    
+    // Read, not assumed: --efficiency, a restart, a scheduled task or a
+    // Run key may start us behind the lock screen or disconnected
+    Update(IsConnected(), QueryLocked());
+    callback_ = callback;
+    context_ = context;
+    return true;
+}
+
+void SessionMonitor::OnSessionChange(WPARAM event) {
+    bool locked = locked_;
+    switch (event) {
+        case WTS_SESSION_LOCK:
+            locked = true;
+            break;
+        case WTS_SESSION_UNLOCK:
+        case WTS_SESSION_LOGON:
+            locked = false;
+            break;
+    }
+    
+    // Connects, disconnects and the end of a remote control (shadow)
+    // session all show up in the connect state
+    Update(IsConnected(), locked);
+}
+
+bool SessionMonitor::IsConnected() {
+    WTS_CONNECTSTATE_CLASS* state = nullptr;
+    DWORD size = 0;
+    if (!WTSQuerySessionInformationW(WTS_CURRENT_SERVER_HANDLE, WTS_CURRENT_SESSION, WTSConnectState,
+                                     reinterpret_cast<LPWSTR*>(&state), &size)) {
+        return true;
+    }
+    bool connected = size >= sizeof(*state) && *state == WTSActive;
+    WTSFreeMemory(state);
+    return connected;
+}
+
+bool SessionMonitor::QueryLocked() {
+    WTSINFOEXW* info = nullptr;
+    DWORD size = 0;
+    if (!WTSQuerySessionInformationW(WTS_CURRENT_SERVER_HANDLE, WTS_CURRENT_SESSION, WTSSessionInfoEx,
+                                     reinterpret_cast<LPWSTR*>(&info), &size)) {
+        return false;
+    }
+    bool locked = size >= sizeof(*info) && info->Level == 1 &&
+                  info->Data.WTSInfoExLevel1.SessionFlags == WTS_SESSIONSTATE_LOCK;
+    WTSFreeMemory(info);
+    return locked;
+}
@@ -0,0 +1,308 @@
+#include "simulation.h"
+#include "config_store.h"
+#include "mouse_engine.h"
+#include "stats.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+namespace {
+constexpr uint64_t kTypingPeriodMs = 2000;
+
+bool ParseSeconds(const std::string& text, uint64_t& ms) {
+    char* end = nullptr;
+    double seconds = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || *end || seconds < 0) {
+        return false;
+    }
+    ms = static_cast<uint64_t>(seconds * 1000 + 0.5);
+    return true;
+}
+}
+
+uint64_t ActivityTrace::LastInputAt(uint64_t now) const {
+    auto it = std::upper_bound(inputs.begin(), inputs.end(), now);
+    return it == inputs.begin() ? kNone : *(it - 1);
+}
+
+uint64_t ActivityTrace::NextInputAfter(uint64_t now) const {
+    auto it = std::upper_bound(inputs.begin(), inputs.end(), now);
+    return it == inputs.end() ? kNone : *it;
+}
+
+void ActivityTrace::Add(uint64_t from, uint64_t to, uint64_t period) {
+    for (uint64_t t = from; t <= to; t += period) {
+        inputs.push_back(t);
+    }
+}
+
+bool ActivityTrace::Load(const std::string& path, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    
+    inputs.clear();
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream iss(line);
+        std::string span;
+        if (!(iss >> span)) {
+            continue;
+        }
+        
+        uint64_t from = 0;
+        uint64_t to = 0;
+        uint64_t period = 1000;
+        size_t dash = span.find('-');
+        std::string text;
+        bool valid = dash == std::string::npos
+            ? ParseSeconds(span, from) && (to = from, true)
+            : ParseSeconds(span.substr(0, dash), from) && ParseSeconds(span.substr(dash + 1), to) && from <= to;
+        if (valid && iss >> text) {
+            valid = ParseSeconds(text, period) && period > 0;
+        }
+        if (!valid || iss >> text) {
+            error = path + ":" + std::to_string(number) + ": expected T or T1-T2 [P] in seconds";
+            return false;
+        }
+        Add(from, to, period);
+    }
+    std::sort(inputs.begin(), inputs.end());
+    return true;
+}
+
+bool ActivityTrace::LoadDecisionTrace(const std::string& path, std::string& error) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    
+    // 64-bit words keep the header and records aligned
+    std::vector<uint64_t> buffer;
+    uint64_t chunk[512];
+    size_t read;
+    while ((read = std::fread(chunk, sizeof(uint64_t), 512, file)) > 0) {
+        buffer.insert(buffer.end(), chunk, chunk + read);
+    }
+    std::fclose(file);
+    
+    const auto* header = reinterpret_cast<const TraceHeader*>(buffer.data());
+    size_t bytes = buffer.size() * sizeof(uint64_t);
+    if (bytes < sizeof(TraceHeader) ||
+        bytes < sizeof(TraceHeader) + static_cast<size_t>(header->capacity) * sizeof(TraceRecord)) {
+        error = path + " is not a decision trace";
+        return false;
+    }
+    std::vector<TraceRecord> records(header->capacity);
+    records.resize(ReadTrace(*header, reinterpret_cast<const TraceRecord*>(header + 1), records.data(),
+                             records.size()));
+    if (records.empty()) {
+        error = path + " holds no records";
+        return false;
+    }
+    
+    // Ticks carry the idle time they saw; times restart at the first record
+    inputs.clear();
+    uint64_t start = records.front().time;
+    for (const TraceRecord& record : records) {
+        if (record.next && record.time >= start + record.idle_ms) {
+            inputs.push_back(record.time - record.idle_ms - start);
+        }
+    }
+    std::sort(inputs.begin(), inputs.end());
+    inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+    return true;
+}
+
+ActivityTrace ActivityTrace::Alternating(uint64_t phase_ms, uint64_t duration_ms) {
+    ActivityTrace trace;
+    if (!phase_ms) {
+        return trace;
+    }
+    for (uint64_t start = phase_ms; start < duration_ms; start += 2 * phase_ms) {
+        trace.Add(start, std::min(start + phase_ms, duration_ms) - 1, kTypingPeriodMs);
+    }
+    return trace;
+}
+
+ActivityTrace ActivityTrace::Synthetic(uint64_t active_mean_ms, uint64_t away_mean_ms, uint64_t duration_ms,
+                                       uint64_t seed) {
+    ActivityTrace trace;
+    std::mt19937_64 random(seed);
+    std::exponential_distribution<double> active(1.0 / static_cast<double>(active_mean_ms));
+    std::exponential_distribution<double> away(1.0 / static_cast<double>(away_mean_ms));
+    
+    // The session starts with the user at the desk
+    uint64_t now = 0;
+    while (now < duration_ms) {
+        uint64_t end = std::min(now + static_cast<uint64_t>(active(random)), duration_ms - 1);
+        trace.Add(now, end, kTypingPeriodMs);
+        now = end + 1 + static_cast<uint64_t>(away(random));
+    }
+    return trace;
+}
+
+SimulatedInputBackend::SimulatedInputBackend(Clock& clock, const ActivityTrace& activity,
+                                             uint64_t reported_timeout_ms)
+    : clock_(clock), activity_(activity), reported_timeout_ms_(reported_timeout_ms) {
+}
+
+bool SimulatedInputBackend::GetCursorPosition(int& x, int& y) {
+    x = x_;
+    y = y_;
+    return true;
+}
+
+bool SimulatedInputBackend::MoveCursorRelative(int dx, int dy) {
+    x_ += dx;
+    y_ += dy;
+    Injected(x_, y_);
+    return true;
+}
+
+bool SimulatedInputBackend::NudgeCursor(int x, int y, int dx, int dy) {
+    Injected(x + dx, y + dy);
+    x_ = x;
+    y_ = y;
+    return true;
+}
+
+ScreenRect SimulatedInputBackend::GetMonitorBounds(int, int) {
+    return bounds_;
+}
+
+std::chrono::milliseconds SimulatedInputBackend::GetUserIdleTime() {
+    uint64_t now = clock_.Now();
+    uint64_t last = activity_.LastInputAt(now);
+    return std::chrono::milliseconds(now - (last == ActivityTrace::kNone ? 0 : last));
+}
+
+std::chrono::milliseconds SimulatedInputBackend::GetIdleTimeout() {
+    return std::chrono::milliseconds(reported_timeout_ms_);
+}
+
+void SimulatedInputBackend::Injected(int x, int y) {
+    if (x < bounds_.left || x >= bounds_.right || y < bounds_.top || y >= bounds_.bottom) {
+        ++out_of_bounds_;
+    }
+    int drift = std::max(std::abs(x - 960), std::abs(y - 540));
+    max_drift_ = std::max(max_drift_, drift);
+}
+
+SimulationResult Simulate(const Config& config, const ActivityTrace& activity, const SimulationOptions& options) {
+    VirtualClock clock(options.wall_start);
+    SimulatedInputBackend backend(clock, activity, options.hide_timeout ? 0 : options.lock_timeout_ms);
+    Stats stats;
+    ConfigStore store;
+    store.Publish(config);
+    MouseEngine engine(store, backend, clock, stats);
+    engine.SeedJitter(options.jitter_seed);
+    
+    SimulationResult result;
+    uint64_t timeout = options.lock_timeout_ms;
+    uint64_t end = options.duration_ms;
+    uint64_t next = 0;              // the session starts unlocked with a tick
+    uint64_t last_input = 0;        // user's or ours, for the OS deadline
+    uint64_t last_user = ActivityTrace::kNone;
+    bool idle_since_input = true;   // no nudge since the user's last input
+    
+    while (next < end) {
+        // The OS locks once no input, the user's or ours, has come for
+        // `timeout`; user input up to the tick pushes that out
+        uint64_t user = activity.LastInputAt(next);
+        if (timeout) {
+            for (uint64_t input = activity.NextInputAfter(last_input);
+                 input <= user && input != ActivityTrace::kNone && input < last_input + timeout;
+                 input = activity.NextInputAfter(input)) {
+                last_input = input;
+            }
+            
+            // Locked: the mover parks until the user comes back and unlocks
+            if (next >= last_input + timeout) {
+                ++result.locks;
+                clock.Set(last_input + timeout);
+                engine.OnSessionLocked(last_input + timeout);
+                next = activity.NextInputAfter(last_input + timeout);
+                if (next == ActivityTrace::kNone) {
+                    break;
+                }
+                last_input = next;
+                continue;
+            }
+        }
+        if (user != ActivityTrace::kNone && user != last_user) {
+            last_user = user;
+            idle_since_input = true;
+        }
+        
+        clock.Set(next);
+        uint64_t now = next;
+        uint64_t nudges = stats.inject_calls.load(std::memory_order_relaxed);
+        next = engine.Tick(now);
+        ++result.wakeups;
+        if (options.wake_counts && now && now / options.wake_bucket_ms < options.wake_counts->size()) {
+            ++(*options.wake_counts)[now / options.wake_bucket_ms];
+        }
+        if (stats.inject_calls.load(std::memory_order_relaxed) == nudges) {
+            continue;
+        }
+        
+        ++result.nudges;
+        last_input = now;
+        if (result.first_nudge_ms == UINT64_MAX) {
+            result.first_nudge_ms = now;
+        }
+        if (idle_since_input) {
+            uint64_t delay = now - (user == ActivityTrace::kNone ? 0 : user);
+            ++result.idle_stretches;
+            result.nudge_delay_sum_ms += delay;
+            result.nudge_delay_max_ms = std::max(result.nudge_delay_max_ms, delay);
+            idle_since_input = false;
+        }
+    }
+    
+    result.out_of_bounds = backend.OutOfBounds();
+    result.max_drift = backend.MaxDrift();
+    result.calibrated_timeout_s = engine.Calibration().Record().timeout_seconds;
+    return result;
+}
+
+FleetResult SimulateFleet(const Config& config, const ActivityTrace& activity, const SimulationOptions& options,
+                          uint32_t instances) {
+    std::vector<uint32_t> counts((options.duration_ms + options.wake_bucket_ms - 1) / options.wake_bucket_ms);
+    SimulationOptions instance = options;
+    instance.wake_counts = &counts;
+    
+    FleetResult result;
+    for (uint32_t i = 0; i < instances; ++i) {
+        instance.jitter_seed = options.jitter_seed + i;
+        result.locks += Simulate(config, activity, instance).locks;
+    }
+    if (counts.empty()) {
+        return result;
+    }
+    
+    uint64_t empty = 0;
+    for (uint32_t count : counts) {
+        result.wakeups += count;
+        result.peak = std::max(result.peak, count);
+        empty += count == 0;
+    }
+    result.mean = static_cast<double>(result.wakeups) / counts.size();
+    double variance = 0;
+    for (uint32_t count : counts) {
+        variance += (count - result.mean) * (count - result.mean);
+    }
+    result.deviation = std::sqrt(variance / counts.size());
+    result.empty_share = static_cast<double>(empty) / counts.size();
+    return result;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "clock.h"
+#include "config.h"
+#include "input_backend.h"
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+// Offline evaluation of the decision core: the real MouseEngine runs on a
+// virtual clock against a simulated desktop whose user input comes from an
+// activity trace, so hours of operation replay in milliseconds.
+
+class VirtualClock : public Clock {
+public:
+    explicit VirtualClock(std::time_t wall_start = 0) : wall_start_(wall_start) {}
+    
+    uint64_t Now() override { return now_; }
+    std::time_t WallTime() override { return wall_start_ + static_cast<std::time_t>(now_ / 1000); }
+    
+    void Set(uint64_t now) { now_ = now; }
+    
+private:
+    uint64_t now_ = 0;
+    std::time_t wall_start_;
+};
+
+// Instants of user input in milliseconds from the start of the trace,
+// sorted
+struct ActivityTrace {
+    std::vector<uint64_t> inputs;
+    
+    // Last input at or before `now`, or kNone
+    uint64_t LastInputAt(uint64_t now) const;
+    
+    // First input after `now`, or kNone
+    uint64_t NextInputAfter(uint64_t now) const;
+    
+    static constexpr uint64_t kNone = UINT64_MAX;
+    
+    // Text format, times in seconds, '#' starts a comment:
+    //   T            one input at T
+    //   T1-T2 [P]    input every P seconds (default 1) from T1 to T2
+    bool Load(const std::string& path, std::string& error);
+    
+    // Inputs recorded in a decision trace (mm --trace): the last user input
+    // each tick saw, so at the resolution of the ticks
+    bool LoadDecisionTrace(const std::string& path, std::string& error);
+    
+    // Typing every 2 s for `phase_ms`, then away for `phase_ms`, starting
+    // away; no input at all if `phase_ms` is 0
+    static ActivityTrace Alternating(uint64_t phase_ms, uint64_t duration_ms);
+    
+    // Active and away stretches with exponentially distributed lengths
+    // around the given means, typing every 2 s while active
+    static ActivityTrace Synthetic(uint64_t active_mean_ms, uint64_t away_mean_ms, uint64_t duration_ms,
+                                   uint64_t seed);
+    
+private:
+    void Add(uint64_t from, uint64_t to, uint64_t period);
+};
+
+// InputBackend of a single 1920x1080 monitor. User input comes from the
+// activity trace at the clock's time; injections move a virtual cursor and
+// count as input for the OS idle timeout, but not for GetUserIdleTime().
+class SimulatedInputBackend : public InputBackend {
+public:
+    // `reported_timeout_ms` is what GetIdleTimeout() returns; 0 hides the
+    // timeout as third-party lock agents do
+    SimulatedInputBackend(Clock& clock, const ActivityTrace& activity, uint64_t reported_timeout_ms);
+    
+    bool GetCursorPosition(int& x, int& y) override;
+    bool MoveCursorRelative(int dx, int dy) override;
+    bool NudgeCursor(int x, int y, int dx, int dy) override;
+    ScreenRect GetMonitorBounds(int x, int y) override;
+    void RefreshMonitors() override {}
+    std::chrono::milliseconds GetUserIdleTime() override;
+    std::chrono::milliseconds GetIdleTimeout() override;
+    
+    // Injections that took the cursor off the monitor
+    uint64_t OutOfBounds() const { return out_of_bounds_; }
+    
+    // Farthest the cursor drifted from where it started, in pixels per axis
+    int MaxDrift() const { return max_drift_; }
+    
+private:
+    void Injected(int x, int y);
+    
+    Clock& clock_;
+    const ActivityTrace& activity_;
+    uint64_t reported_timeout_ms_;
+    ScreenRect bounds_ = {0, 0, 1920, 1080};
+    int x_ = 960;
+    int y_ = 540;
+    uint64_t out_of_bounds_ = 0;
+    int max_drift_ = 0;
+};
+
+struct SimulationOptions {
+    uint64_t duration_ms = 8 * 3600000ull;
+    uint64_t lock_timeout_ms = 15 * 60000;  // OS locks this long after the last input, ours included; 0 never
+    bool hide_timeout = false;              // GetIdleTimeout() reports nothing (--calibrate's case)
+    std::time_t wall_start = 0;             // wall clock at the start, for calibration
+    uint64_t jitter_seed = 0;               // MouseEngine::SeedJitter
+    
+    // If set, every tick after the one at the start adds one to the bucket
+    // of its time, buckets being wake_bucket_ms wide
+    std::vector<uint32_t>* wake_counts = nullptr;
+    uint64_t wake_bucket_ms = 100;
+};
+
+struct SimulationResult {
+    uint64_t wakeups = 0;           // engine ticks
+    uint64_t nudges = 0;            // injections
+    uint64_t locks = 0;             // lock deadlines the mover missed
+    uint64_t first_nudge_ms = UINT64_MAX;   // since the start; UINT64_MAX if none
+    uint64_t idle_stretches = 0;    // user went idle and got nudged before coming back
+    uint64_t nudge_delay_sum_ms = 0;
+    uint64_t nudge_delay_max_ms = 0;        // last user input to the first nudge after it
+    uint64_t out_of_bounds = 0;
+    int max_drift = 0;
+    uint32_t calibrated_timeout_s = 0;      // what --calibrate learned, if anything
+};
+
+// Runs the movement logic of `config` (--power and schedules are not
+// simulated) over `activity` and models the OS lock: once locked, the
+// mover parks as on a real session change until the next user input
+// unlocks. Never touches the real clock or desktop.
+SimulationResult Simulate(const Config& config, const ActivityTrace& activity, const SimulationOptions& options);
+
+// How the wakeups of a fleet spread over time, per bucket of
+// options.wake_bucket_ms
+struct FleetResult {
+    double mean = 0;            // wakeups per bucket
+    uint32_t peak = 0;          // in the busiest bucket
+    double deviation = 0;       // standard deviation across buckets
+    double empty_share = 0;     // share of buckets nobody woke in
+    uint64_t wakeups = 0;
+    uint64_t locks = 0;         // summed over the instances
+};
+
+// `instances` movers on one host that all start at the same instant and
+// replay the same activity, as after a logon storm on a VDI host; each
+// seeds its jitter with options.jitter_seed plus its index, so only the
+// jitter tells them apart
+FleetResult SimulateFleet(const Config& config, const ActivityTrace& activity, const SimulationOptions& options,
+                          uint32_t instances);
@@ -0,0 +1,229 @@
+#include "stats.h"
+#include <cstdarg>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+namespace {
+int BucketIndex(uint64_t value) {
+    int index = 0;
+    while (value && index < Histogram::kBuckets - 1) {
+        value >>= 1;
+        ++index;
+    }
+    return index;
+}
+
+// snprintf appends that stop cleanly at the end of the buffer
+void Append(char* buffer, size_t size, size_t& length, const char* format, ...) {
+    if (length >= size) {
+        return;
+    }
+    
+    va_list args;
+    va_start(args, format);
+    int written = std::vsnprintf(buffer + length, size - length, format, args);
+    va_end(args);
+    
+    if (written > 0) {
+        length += static_cast<size_t>(written);
+        if (length >= size) {
+            length = size - 1;
+        }
+    }
+}
+}
+
+void Histogram::Record(uint64_t value) {
+    buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t Histogram::Percentile(int percentile) const {
+    uint64_t count = Count();
+    if (!count) {
+        return 0;
+    }
+    
+    uint64_t target = (count * static_cast<uint64_t>(percentile) + 99) / 100;
+    uint64_t seen = 0;
+    int i = 0;
+    for (; i < kBuckets; ++i) {
+        seen += Bucket(i);
+        if (seen >= target) {
+            break;
+        }
+    }
+    
+    // The bucket bound can overshoot everything actually recorded
+    uint64_t bound = BucketUpperBound(i < kBuckets ? i : kBuckets - 1);
+    uint64_t max = Max();
+    return bound < max ? bound : max;
+}
+
+uint64_t Histogram::BucketUpperBound(int index) {
+    return index ? (uint64_t(1) << index) - 1 : 0;
+}
+
+void Stats::RecordWakeup(uint64_t now, uint64_t intended) {
+    wakeups.fetch_add(1, std::memory_order_relaxed);
+    lateness_ms.Record(now > intended ? now - intended : 0);
+}
+
+void Stats::RecordSkip(SkipReason reason) {
+    skipped[static_cast<int>(reason)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Stats::RecordResume(uint64_t paused_for, uint64_t tick_interval) {
+    pauses.fetch_add(1, std::memory_order_relaxed);
+    paused_ms.fetch_add(paused_for, std::memory_order_relaxed);
+    if (tick_interval) {
+        skipped[static_cast<int>(SkipReason::kPaused)].fetch_add(paused_for / tick_interval, std::memory_order_relaxed);
+    }
+}
+
+void Stats::RecordInjection(bool succeeded) {
+    inject_calls.fetch_add(1, std::memory_order_relaxed);
+    if (!succeeded) {
+        inject_failures.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+size_t Stats::Format(uint64_t now, char* buffer, size_t size) const {
+    size_t length = 0;
+    uint64_t uptime_ms = now > start_time ? now - start_time : 0;
+    uint64_t wakeup_count = wakeups.load(std::memory_order_relaxed);
+    uint64_t cpu_us = GetProcessCpuMicroseconds();
+    
+    Append(buffer, size, length, "uptime_s=%llu\n", (unsigned long long)(uptime_ms / 1000));
+    Append(buffer, size, length, "wakeups=%llu\n", (unsigned long long)wakeup_count);
+    Append(buffer, size, length, "wakeups_per_hour=%llu\n",
+           (unsigned long long)(uptime_ms ? wakeup_count * 3600000 / uptime_ms : 0));
+    Append(buffer, size, length, "skipped_user_active=%llu\n",
+           (unsigned long long)skipped[static_cast<int>(SkipReason::kUserActive)].load(std::memory_order_relaxed));
+    Append(buffer, size, length, "skipped_long_delay=%llu\n",
+           (unsigned long long)skipped[static_cast<int>(SkipReason::kLongDelay)].load(std::memory_order_relaxed));
+    Append(buffer, size, length, "skipped_paused=%llu\n",
+           (unsigned long long)skipped[static_cast<int>(SkipReason::kPaused)].load(std::memory_order_relaxed));
+    Append(buffer, size, length, "pauses=%llu\n", (unsigned long long)pauses.load(std::memory_order_relaxed));
+    Append(buffer, size, length, "paused_s=%llu\n", (unsigned long long)(paused_ms.load(std::memory_order_relaxed) / 1000));
+    Append(buffer, size, length, "inject_calls=%llu\n", (unsigned long long)inject_calls.load(std::memory_order_relaxed));
+    Append(buffer, size, length, "inject_failures=%llu\n", (unsigned long long)inject_failures.load(std::memory_order_relaxed));
+    Append(buffer, size, length, "lateness_ms_p50=%llu\n", (unsigned long long)lateness_ms.Percentile(50));
+    Append(buffer, size, length, "lateness_ms_p99=%llu\n", (unsigned long long)lateness_ms.Percentile(99));
+    Append(buffer, size, length, "lateness_ms_max=%llu\n", (unsigned long long)lateness_ms.Max());
+    
+    // Only non-empty buckets, labelled with their upper bound
+    Append(buffer, size, length, "lateness_ms_hist=");
+    for (int i = 0; i < Histogram::kBuckets; ++i) {
+        uint64_t count = lateness_ms.Bucket(i);
+        if (count) {
+            Append(buffer, size, length, "%llu:%llu ",
+                   (unsigned long long)Histogram::BucketUpperBound(i), (unsigned long long)count);
+        }
+    }
+    Append(buffer, size, length, "\n");
+    
+    if (hook_cost_ns.Count()) {
+        Append(buffer, size, length, "hook_calls=%llu\n", (unsigned long long)hook_cost_ns.Count());
+        Append(buffer, size, length, "hook_cost_ns_p50=%llu\n", (unsigned long long)hook_cost_ns.Percentile(50));
+        Append(buffer, size, length, "hook_cost_ns_p99=%llu\n", (unsigned long long)hook_cost_ns.Percentile(99));
+        Append(buffer, size, length, "hook_cost_ns_max=%llu\n", (unsigned long long)hook_cost_ns.Max());
+    }
+    
+    Append(buffer, size, length, "cpu_ms=%llu\n", (unsigned long long)(cpu_us / 1000));
+    
+    ProcessMemory memory;
+    if (GetProcessMemory(0, memory)) {
+        Append(buffer, size, length, "working_set_kb=%llu\n", (unsigned long long)(memory.working_set / 1024));
+        Append(buffer, size, length, "private_kb=%llu\n", (unsigned long long)(memory.private_bytes / 1024));
+    }
+    return length;
+}
+
+size_t Stats::FormatSummary(char* buffer, size_t size) const {
+    size_t length = 0;
+    Append(buffer, size, length, "Moves: %llu, wakeups: %llu, late p99: %llums",
+           (unsigned long long)inject_calls.load(std::memory_order_relaxed),
+           (unsigned long long)wakeups.load(std::memory_order_relaxed),
+           (unsigned long long)lateness_ms.Percentile(99));
+    return length;
+}
+
+uint64_t GetProcessCpuMicroseconds() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    // FILETIME counts 100 ns units
+    uint64_t kernel_time = (static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+    uint64_t user_time = (static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return (kernel_time + user_time) / 10;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+           static_cast<uint64_t>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+#endif
+}
+
+bool GetProcessMemory(uint64_t pid, ProcessMemory& memory) {
+#ifdef _WIN32
+    HANDLE process = pid ? OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(pid))
+                         : GetCurrentProcess();
+    if (!process) {
+        return false;
+    }
+    PROCESS_MEMORY_COUNTERS_EX counters = { sizeof(counters) };
+    bool succeeded = GetProcessMemoryInfo(process, reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters),
+                                          sizeof(counters)) != FALSE;
+    if (pid) {
+        CloseHandle(process);
+    }
+    if (succeeded) {
+        memory.working_set = counters.WorkingSetSize;
+        memory.private_bytes = counters.PrivateUsage;
+    }
+    return succeeded;
+#else
+    char path[64];
+    std::snprintf(path, sizeof(path), pid ? "/proc/%llu/status" : "/proc/self/status", (unsigned long long)pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    char text[4096];
+    ssize_t length = read(fd, text, sizeof(text) - 1);
+    close(fd);
+    if (length <= 0) {
+        return false;
+    }
+    text[length] = '\0';
+    
+    // Values are in kB
+    const char* rss = std::strstr(text, "VmRSS:");
+    const char* anonymous = std::strstr(text, "RssAnon:");
+    if (!rss || !anonymous) {
+        return false;
+    }
+    memory.working_set = std::strtoull(rss + 6, nullptr, 10) * 1024;
+    memory.private_bytes = std::strtoull(anonymous + 8, nullptr, 10) * 1024;
+    return true;
+#endif
+}
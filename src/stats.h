@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-bucket log2 histogram. Bucket 0 counts zeros, bucket i counts
+// values in [2^(i-1), 2^i); the last bucket absorbs everything larger.
+// Recording is a handful of relaxed atomic operations: lock-free and
+// allocation-free.
+class Histogram {
+public:
+    static constexpr int kBuckets = 32;
+    
+    void Record(uint64_t value);
+    
+    uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t Max() const { return max_.load(std::memory_order_relaxed); }
+    uint64_t Bucket(int index) const { return buckets_[index].load(std::memory_order_relaxed); }
+    
+    // Upper bound of the bucket holding the given percentile (0-100)
+    uint64_t Percentile(int percentile) const;
+    
+    static uint64_t BucketUpperBound(int index);
+    
+private:
+    std::atomic<uint64_t> buckets_[kBuckets] = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// Why a scheduled tick did not move the mouse
+enum class SkipReason {
+    kUserActive,    // fresh user input since the previous tick
+    kLongDelay,     // still inside the long_delay window after earlier input
+    kPaused,        // moves that would have run while paused
+    kCount,
+};
+
+// Hot-path counters for the mover. Written from the reactor thread, may be
+// read from anywhere.
+struct Stats {
+    std::atomic<uint64_t> wakeups{0};
+    std::atomic<uint64_t> skipped[static_cast<int>(SkipReason::kCount)] = {};
+    std::atomic<uint64_t> inject_calls{0};
+    std::atomic<uint64_t> inject_failures{0};
+    std::atomic<uint64_t> pauses{0};
+    std::atomic<uint64_t> paused_ms{0};
+    Histogram lateness_ms;      // actual wake time minus intended wake time
+    Histogram hook_cost_ns;     // time spent in each input hook callback
+    uint64_t start_time = 0;    // reactor milliseconds
+    
+    void RecordWakeup(uint64_t now, uint64_t intended);
+    void RecordSkip(SkipReason reason);
+    void RecordResume(uint64_t paused_for, uint64_t tick_interval);
+    void RecordInjection(bool succeeded);
+    
+    // Multi-line key=value dump and one-line summary; both write into the
+    // caller's buffer, never allocate, and return the formatted length
+    size_t Format(uint64_t now, char* buffer, size_t size) const;
+    size_t FormatSummary(char* buffer, size_t size) const;
+};
+
+// User plus kernel CPU time consumed by this process
+uint64_t GetProcessCpuMicroseconds();
+
+// Working set and private (committed on Windows, anonymous resident on
+// Linux) memory of a process in bytes; pid 0 means this process. Reads
+// without allocating.
+struct ProcessMemory {
+    uint64_t working_set = 0;
+    uint64_t private_bytes = 0;
+};
+bool GetProcessMemory(uint64_t pid, ProcessMemory& memory);
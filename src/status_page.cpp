@@ -0,0 +1,82 @@
+#include "status_page.h"
+#include <chrono>
+#include <cstring>
+
+namespace {
+const char* kStateNames[] = { "running", "paused", "power", "off", "away" };
+
+// A writer holds the sequence odd for a few dozen stores; give up well after
+constexpr int kReadAttempts = 1000;
+
+uint64_t UnixMilliseconds() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+// Reactor time to Unix time through the current offset between the two
+uint64_t ToUnixTime(uint64_t time, uint64_t now, uint64_t unix_now) {
+    return time ? unix_now + time - now : 0;
+}
+}
+
+const char* StatusStateName(uint64_t state) {
+    return state < sizeof(kStateNames) / sizeof(kStateNames[0]) ? kStateNames[state] : "?";
+}
+
+bool ReadStatusPage(const StatusPage& page, StatusSnapshot& snapshot) {
+    if (page.magic != StatusPage::kMagic || page.version != StatusPage::kVersion ||
+        page.size != sizeof(StatusPage)) {
+        return false;
+    }
+    
+    uint64_t values[StatusPage::kFields];
+    for (int attempt = 0; attempt < kReadAttempts; ++attempt) {
+        uint32_t begin = page.sequence.load(std::memory_order_acquire);
+        if (begin & 1) {
+            continue;
+        }
+        for (int i = 0; i < StatusPage::kFields; ++i) {
+            values[i] = page.fields[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (page.sequence.load(std::memory_order_relaxed) == begin) {
+            std::memcpy(&snapshot, values, sizeof(values));
+            return true;
+        }
+    }
+    return false;
+}
+
+void StatusPageWriter::Publish(const StatusSnapshot& snapshot, const Stats& stats, uint64_t now) {
+    if (!page_) {
+        return;
+    }
+    
+    StatusSnapshot published = snapshot;
+    uint64_t unix_now = UnixMilliseconds();
+    published.update_time = unix_now;
+    published.start_time = ToUnixTime(snapshot.start_time, now, unix_now);
+    published.last_move_time = ToUnixTime(snapshot.last_move_time, now, unix_now);
+    published.last_input_time = ToUnixTime(snapshot.last_input_time, now, unix_now);
+    published.next_wake_time = ToUnixTime(snapshot.next_wake_time, now, unix_now);
+    published.resume_time = ToUnixTime(snapshot.resume_time, now, unix_now);
+    published.wakeups = stats.wakeups.load(std::memory_order_relaxed);
+    published.moves = stats.inject_calls.load(std::memory_order_relaxed);
+    published.inject_failures = stats.inject_failures.load(std::memory_order_relaxed);
+    published.skipped_user_active = stats.skipped[static_cast<int>(SkipReason::kUserActive)].load(std::memory_order_relaxed);
+    published.skipped_long_delay = stats.skipped[static_cast<int>(SkipReason::kLongDelay)].load(std::memory_order_relaxed);
+    published.pauses = stats.pauses.load(std::memory_order_relaxed);
+    published.paused_ms = stats.paused_ms.load(std::memory_order_relaxed);
+    
+    uint64_t values[StatusPage::kFields];
+    std::memcpy(values, &published, sizeof(values));
+    
+    // Odd while the fields are in flux; only this thread ever writes
+    uint32_t sequence = page_->sequence.load(std::memory_order_relaxed);
+    page_->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < StatusPage::kFields; ++i) {
+        page_->fields[i].store(values[i], std::memory_order_relaxed);
+    }
+    page_->sequence.store(sequence + 2, std::memory_order_release);
+}
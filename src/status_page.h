@@ -0,0 +1,93 @@
+#pragma once
+
+#include "stats.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Plain copy of the published status. Times are Unix milliseconds, 0 when
+// there is none.
+struct StatusSnapshot {
+    enum State : uint64_t {
+        kRunning = 0,
+        kPaused = 1,
+        kPowerRequest = 2,      // held awake by a power request, no movement
+        kOffSchedule = 3,       // outside the working hours, asleep until they start
+        kAway = 4,              // session locked, disconnected or switched away from
+    };
+    
+    uint64_t pid = 0;
+    uint64_t state = kRunning;
+    uint64_t short_delay = 0;
+    uint64_t long_delay = 0;
+    uint64_t distance = 0;
+    uint64_t start_time = 0;
+    uint64_t update_time = 0;
+    uint64_t last_move_time = 0;
+    uint64_t last_input_time = 0;
+    uint64_t next_wake_time = 0;
+    uint64_t resume_time = 0;       // end of a timed pause
+    uint64_t wakeups = 0;
+    uint64_t moves = 0;
+    uint64_t inject_failures = 0;
+    uint64_t skipped_user_active = 0;
+    uint64_t skipped_long_delay = 0;
+    uint64_t pauses = 0;
+    uint64_t paused_ms = 0;
+};
+
+// Fixed-layout page in named shared memory, one per running instance:
+// Local\MouseMover-Status on Windows (Session\<id>\MouseMover-Status from
+// other sessions), /dev/shm/mm-status-<uid>-<session> on Linux,
+// keyed on XDG_SESSION_ID or, without it, the display.
+//
+// The fields are guarded by a seqlock: the writer makes the sequence odd,
+// stores, and makes it even again, so it never waits for readers. A reader
+// retries while the sequence is odd or changed under it.
+struct StatusPage {
+    static constexpr uint32_t kMagic = 0x54534d4d;     // "MMST"
+    static constexpr uint32_t kVersion = 1;
+    static constexpr int kFields = sizeof(StatusSnapshot) / sizeof(uint64_t);
+    
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                  // sizeof(StatusPage), so readers can check the layout
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint64_t> fields[kFields];      // StatusSnapshot, field by field
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "status page atomics must be address-free");
+
+// "running", "paused", "power", "off", "away", or "?" for a newer state
+const char* StatusStateName(uint64_t state);
+
+// False if the page has another layout or the writer kept it busy
+bool ReadStatusPage(const StatusPage& page, StatusSnapshot& snapshot);
+
+// Owns this instance's page. Publish() is called on the reactor thread
+// whenever the state changes, so monitoring costs no extra wakeups.
+class StatusPageWriter {
+public:
+    StatusPageWriter() = default;
+    ~StatusPageWriter();
+    StatusPageWriter(const StatusPageWriter&) = delete;
+    StatusPageWriter& operator=(const StatusPageWriter&) = delete;
+    
+    bool Open(std::string& error);
+    
+    // Times in the snapshot are reactor milliseconds (0 for none) and are
+    // converted here; the counters are taken from stats
+    void Publish(const StatusSnapshot& snapshot, const Stats& stats, uint64_t now);
+
+private:
+    StatusPage* page_ = nullptr;
+#ifdef _WIN32
+    HANDLE mapping_ = nullptr;
+#else
+    std::string name_;
+#endif
+};
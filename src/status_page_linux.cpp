@@ -0,0 +1,72 @@
+#include "status_page.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+// The logind session, else the display: one user may run an instance in
+// each of several sessions (a console and remote desktops)
+std::string SessionKey() {
+    const char* session = std::getenv("XDG_SESSION_ID");
+    if (!session || !*session) {
+        session = std::getenv("DISPLAY");
+    }
+    std::string key = session && *session ? session : "none";
+    for (char& c : key) {
+        if (c == '/') {
+            c = '_';
+        }
+    }
+    return key;
+}
+}
+
+StatusPageWriter::~StatusPageWriter() {
+    if (page_) {
+        munmap(page_, sizeof(StatusPage));
+        shm_unlink(name_.c_str());
+    }
+}
+
+bool StatusPageWriter::Open(std::string& error) {
+    // Readable by everyone, so a monitoring agent under another account can scan it
+    std::string name = "/mm-status-" + std::to_string(getuid()) + "-" + SessionKey();
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd < 0) {
+        error = "shm_open " + name + ": " + std::strerror(errno);
+        return false;
+    }
+    if (ftruncate(fd, sizeof(StatusPage)) != 0) {
+        error = "ftruncate " + name + ": " + std::strerror(errno);
+        close(fd);
+        return false;
+    }
+    void* memory = mmap(nullptr, sizeof(StatusPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        error = "mmap " + name + ": " + std::strerror(errno);
+        return false;
+    }
+    auto* page = static_cast<StatusPage*>(memory);
+    
+    // A page left by a crashed instance is taken over; a live writer keeps it
+    StatusSnapshot existing;
+    if (ReadStatusPage(*page, existing) && existing.pid != static_cast<uint64_t>(getpid()) &&
+        existing.pid && kill(static_cast<pid_t>(existing.pid), 0) == 0) {
+        munmap(memory, sizeof(StatusPage));
+        error = "another instance publishes " + name;
+        return false;
+    }
+    
+    page->magic = StatusPage::kMagic;
+    page->version = StatusPage::kVersion;
+    page->size = sizeof(StatusPage);
+    page->sequence.store(page->sequence.load(std::memory_order_relaxed) & ~1u, std::memory_order_release);
+    page_ = page;
+    name_ = name;
+    return true;
+}
@@ -0,0 +1,39 @@
+#include "status_page.h"
+
+StatusPageWriter::~StatusPageWriter() {
+    if (page_) {
+        UnmapViewOfFile(page_);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+    }
+}
+
+bool StatusPageWriter::Open(std::string& error) {
+    // Session-local name; readers elsewhere use Session\<id>\MouseMover-Status.
+    // The section goes away with the last handle, so it cannot go stale.
+    mapping_ = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(StatusPage),
+                                  L"Local\\MouseMover-Status");
+    if (!mapping_) {
+        error = "cannot create the status page";
+        return false;
+    }
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+        error = "another instance publishes its status in this session";
+        return false;
+    }
+    
+    page_ = static_cast<StatusPage*>(MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, sizeof(StatusPage)));
+    if (!page_) {
+        error = "cannot map the status page";
+        return false;
+    }
+    
+    // New sections are zero filled, so the sequence starts even
+    page_->magic = StatusPage::kMagic;
+    page_->version = StatusPage::kVersion;
+    page_->size = sizeof(StatusPage);
+    return true;
+}
@@ -0,0 +1,194 @@
+#include "timer_wheel.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+constexpr int kHorizonBits = 36;   // kLevels * kLevelBits
+
+int CountTrailingZeros(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+}
+
+TimerWheel::TimerWheel(uint64_t now) : current_(now) {
+}
+
+void TimerWheel::Schedule(Timer& timer, uint64_t expires) {
+    if (timer.IsArmed()) {
+        Unlink(timer);
+    }
+    timer.expires_ = expires;
+    Insert(timer);
+}
+
+void TimerWheel::Cancel(Timer& timer) {
+    if (timer.IsArmed()) {
+        Unlink(timer);
+    }
+}
+
+void TimerWheel::Advance(uint64_t now) {
+    while (current_ <= now) {
+        CascadeAndFire();
+
+        // Jump straight to the next occupied slot instead of ticking through empty ones
+        uint64_t next = NextSlotStart();
+        if (next <= current_) {
+            next = current_ + 1;
+        }
+        current_ = next <= now ? next : now + 1;
+    }
+}
+
+uint64_t TimerWheel::NextExpiry() const {
+    uint64_t earliest = kNever;
+
+    for (int level = 0; level < kLevels; ++level) {
+        int slot = FirstOccupiedSlot(level);
+        if (slot < 0) {
+            continue;
+        }
+        if (level == 0) {
+            uint64_t start = SlotStart(0, slot);
+            earliest = start < earliest ? start : earliest;
+            continue;
+        }
+        // Higher-level slots span many ticks, so look at the timers themselves
+        for (const Timer* timer = slots_[level][slot]; timer; timer = timer->next_) {
+            uint64_t expires = timer->expires_ > current_ ? timer->expires_ : current_;
+            earliest = expires < earliest ? expires : earliest;
+        }
+    }
+    return earliest;
+}
+
+void TimerWheel::Insert(Timer& timer) {
+    uint64_t place = timer.expires_ > current_ ? timer.expires_ : current_;
+
+    // A callback re-arming itself for "now" runs on the next tick, not in a loop
+    if (firing_ && place <= current_) {
+        place = current_ + 1;
+    }
+
+    int level = 0;
+    uint64_t diff = place ^ current_;
+    if (diff >> kHorizonBits) {
+        // Past the top-level window: wrap around its slots, at most one turn
+        // ahead, parking anything further out in the last reachable slot
+        int top_shift = kLevelBits * (kLevels - 1);
+        uint64_t limit = ((current_ >> top_shift) << top_shift) + (uint64_t(1) << kHorizonBits);
+        if (place >= limit) {
+            place = limit - 1;
+        }
+        level = kLevels - 1;
+    } else {
+        while (level < kLevels - 1 && (diff >> (kLevelBits * (level + 1)))) {
+            ++level;
+        }
+    }
+    int slot = static_cast<int>((place >> (kLevelBits * level)) & (kSlots - 1));
+
+    timer.level_ = level;
+    timer.slot_ = slot;
+    timer.prev_ = nullptr;
+    timer.next_ = slots_[level][slot];
+    if (timer.next_) {
+        timer.next_->prev_ = &timer;
+    }
+    slots_[level][slot] = &timer;
+    occupied_[level] |= uint64_t(1) << slot;
+}
+
+void TimerWheel::Unlink(Timer& timer) {
+    int level = timer.level_;
+    int slot = timer.slot_;
+
+    if (timer.prev_) {
+        timer.prev_->next_ = timer.next_;
+    } else {
+        slots_[level][slot] = timer.next_;
+    }
+    if (timer.next_) {
+        timer.next_->prev_ = timer.prev_;
+    }
+    if (!slots_[level][slot]) {
+        occupied_[level] &= ~(uint64_t(1) << slot);
+    }
+
+    timer.next_ = nullptr;
+    timer.prev_ = nullptr;
+    timer.level_ = -1;
+}
+
+int TimerWheel::FirstOccupiedSlot(int level) const {
+    uint64_t bits = occupied_[level];
+    if (!bits) {
+        return -1;
+    }
+
+    // Rotate so the search starts at the slot of the current tick
+    int index = static_cast<int>((current_ >> (kLevelBits * level)) & (kSlots - 1));
+    uint64_t rotated = index ? (bits >> index) | (bits << (kSlots - index)) : bits;
+    return (index + CountTrailingZeros(rotated)) & (kSlots - 1);
+}
+
+uint64_t TimerWheel::SlotStart(int level, int slot) const {
+    int shift = kLevelBits * level;
+    int window = shift + kLevelBits;
+    int index = static_cast<int>((current_ >> shift) & (kSlots - 1));
+
+    uint64_t start = ((current_ >> window) << window) | (uint64_t(slot) << shift);
+    if (slot < index) {
+        start += uint64_t(1) << window;
+    }
+    return start;
+}
+
+uint64_t TimerWheel::NextSlotStart() const {
+    uint64_t earliest = kNever;
+    for (int level = 0; level < kLevels; ++level) {
+        int slot = FirstOccupiedSlot(level);
+        if (slot >= 0) {
+            uint64_t start = SlotStart(level, slot);
+            earliest = start < earliest ? start : earliest;
+        }
+    }
+    return earliest;
+}
+
+void TimerWheel::CascadeAndFire() {
+    // Move timers from higher-level slots that start at this tick down the wheel
+    for (int level = kLevels - 1; level > 0; --level) {
+        int shift = kLevelBits * level;
+        if (current_ & ((uint64_t(1) << shift) - 1)) {
+            continue;
+        }
+        int slot = static_cast<int>((current_ >> shift) & (kSlots - 1));
+        Timer* timer = slots_[level][slot];
+        slots_[level][slot] = nullptr;
+        occupied_[level] &= ~(uint64_t(1) << slot);
+
+        while (timer) {
+            Timer* next = timer->next_;
+            Insert(*timer);
+            timer = next;
+        }
+    }
+
+    // Fire one at a time so callbacks may cancel or re-arm any timer
+    int slot = static_cast<int>(current_ & (kSlots - 1));
+    firing_ = true;
+    while (Timer* timer = slots_[0][slot]) {
+        Unlink(*timer);
+        timer->callback_(timer->context_);
+    }
+    firing_ = false;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+
+// Hierarchical timer wheel with millisecond resolution. Six levels of 64
+// slots cover ~795 days; timers further out are parked in the last slot and
+// re-inserted when it cascades. Timers are intrusive, so scheduling never
+// allocates.
+class TimerWheel {
+public:
+    using Callback = void (*)(void* context);
+
+    static constexpr uint64_t kNever = UINT64_MAX;
+
+    class Timer {
+    public:
+        Timer(Callback callback, void* context) : callback_(callback), context_(context) {}
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+        bool IsArmed() const { return level_ >= 0; }
+        uint64_t Expiry() const { return expires_; }
+
+    private:
+        friend class TimerWheel;
+
+        Callback callback_;
+        void* context_;
+        uint64_t expires_ = 0;
+        Timer* next_ = nullptr;
+        Timer* prev_ = nullptr;
+        int level_ = -1;
+        int slot_ = 0;
+    };
+
+    explicit TimerWheel(uint64_t now);
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // Arms the timer, moving it if it is already armed
+    void Schedule(Timer& timer, uint64_t expires);
+    void Cancel(Timer& timer);
+
+    // Fires every timer that expires at or before now
+    void Advance(uint64_t now);
+
+    // Earliest expiry of any armed timer, or kNever
+    uint64_t NextExpiry() const;
+
+private:
+    static constexpr int kLevelBits = 6;
+    static constexpr int kSlots = 1 << kLevelBits;
+    static constexpr int kLevels = 6;
+
+    void Insert(Timer& timer);
+    void Unlink(Timer& timer);
+    int FirstOccupiedSlot(int level) const;
+    uint64_t SlotStart(int level, int slot) const;
+    uint64_t NextSlotStart() const;
+    void CascadeAndFire();
+
+    Timer* slots_[kLevels][kSlots] = {};
+    uint64_t occupied_[kLevels] = {};
+    uint64_t current_;      // next tick to be processed
+    bool firing_ = false;
+};
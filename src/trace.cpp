@@ -0,0 +1,61 @@
+#include "trace.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+const char* kEventNames[] = {
+    "moved", "nudged", "user-active", "long-delay", "waiting", "paused", "resumed", "away", "back", "config",
+};
+static_assert(sizeof(kEventNames) / sizeof(kEventNames[0]) == static_cast<size_t>(TraceEvent::kCount),
+              "one name per trace event");
+}
+
+const char* TraceEventName(uint8_t event) {
+    return event < static_cast<uint8_t>(TraceEvent::kCount) ? kEventNames[event] : "?";
+}
+
+TraceRing::TraceRing() : header_(&memory_header_), records_(memory_records_) {
+    memory_header_.magic = TraceHeader::kMagic;
+    memory_header_.version = TraceHeader::kVersion;
+    memory_header_.record_size = sizeof(TraceRecord);
+    memory_header_.capacity = kMemoryRecords;
+}
+
+bool TraceRing::Dump(const std::string& path, std::string& error) const {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        error = "cannot write " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    bool written = std::fwrite(header_, sizeof(TraceHeader), 1, file) == 1 &&
+                   std::fwrite(records_, sizeof(TraceRecord), header_->capacity, file) == header_->capacity;
+    if (std::fclose(file) != 0 || !written) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+size_t ReadTrace(const TraceHeader& header, const TraceRecord* records, TraceRecord* out, size_t max_records) {
+    if (header.magic != TraceHeader::kMagic || header.version != TraceHeader::kVersion ||
+        header.record_size != sizeof(TraceRecord) || !header.capacity ||
+        (header.capacity & (header.capacity - 1))) {
+        return 0;
+    }
+    
+    // A live writer may overwrite the oldest slots meanwhile; those, and a
+    // record torn by a crash, fail the sequence check and are left out
+    uint64_t head = header.head.load(std::memory_order_acquire);
+    uint64_t first = head > header.capacity ? head - header.capacity : 0;
+    size_t count = 0;
+    for (uint64_t index = first; index < head && count < max_records; ++index) {
+        const TraceRecord& slot = records[index & (header.capacity - 1)];
+        out[count] = slot;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (out[count].sequence == index + 1 && slot.sequence == index + 1) {
+            ++count;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// What a trace record stands for
+enum class TraceEvent : uint8_t {
+    kMoved,         // tick moved the mouse
+    kNudged,        // moved on request (--ctl nudge, tray)
+    kUserActive,    // tick skipped: fresh user input
+    kLongDelay,     // tick skipped: inside the long_delay window
+    kWaiting,       // tick woke early, next move not due yet
+    kPaused,
+    kResumed,
+    kAway,          // session locked, disconnected or switched away from
+    kBack,          // session in use again
+    kConfig,        // a new effective configuration was published
+    kCount,
+};
+
+// One fixed-size binary record, filled in on the hot path without any
+// formatting. Fields that do not apply to an event are 0.
+struct TraceRecord {
+    uint64_t sequence;          // position in the trace + 1; 0 while being written
+    uint64_t time;              // reactor milliseconds
+    uint64_t next;              // when the next tick is due
+    uint32_t config_version;    // ConfigStore::Version()
+    uint32_t idle_ms;           // user idle time the decision saw, saturated
+    int32_t x;                  // cursor before the move
+    int32_t y;
+    int16_t dx;
+    int16_t dy;
+    uint8_t event;              // TraceEvent
+    uint8_t result;             // 1 if the injection went through
+    uint16_t reserved;
+    int32_t bounds[4];          // left, top, right, bottom of the cursor's monitor
+};
+
+static_assert(sizeof(TraceRecord) == 64, "trace records are one cache line");
+
+// Ring layout, in memory or in a file: the header, then `capacity`
+// records. Record number n goes to slot n % capacity.
+struct TraceHeader {
+    static constexpr uint32_t kMagic = 0x52544d4d;     // "MMTR"
+    static constexpr uint32_t kVersion = 1;
+    
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;           // sizeof(TraceRecord)
+    uint32_t capacity;              // a power of two
+    std::atomic<uint64_t> head;     // records written so far
+    uint64_t reserved[5];
+};
+
+static_assert(sizeof(TraceHeader) == 64, "the header fills one cache line");
+
+const char* TraceEventName(uint8_t event);
+
+// Single-writer ring of the last decisions, written on the reactor thread.
+// Recording stores one record and bumps the head: no locks, no
+// allocation, no system call. The record's sequence goes in last, so a
+// reader in another process or after a crash can tell complete records
+// from torn ones.
+//
+// By default the ring is kMemoryRecords long and lives in the process;
+// `--ctl trace PATH` writes it out. MapFile() moves it to a file of
+// kFileRecords instead (--trace PATH), which outlives the process.
+class TraceRing {
+public:
+    static constexpr uint32_t kMemoryRecords = 256;
+    static constexpr uint32_t kFileRecords = 16384;
+    
+    TraceRing();
+    ~TraceRing();
+    TraceRing(const TraceRing&) = delete;
+    TraceRing& operator=(const TraceRing&) = delete;
+    
+    bool MapFile(const std::string& path, std::string& error);
+    
+    // The caller fills in everything but the sequence
+    void Record(TraceRecord record) {
+        uint64_t index = header_->head.load(std::memory_order_relaxed);
+        TraceRecord& slot = records_[index & (header_->capacity - 1)];
+        slot.sequence = 0;
+        std::atomic_thread_fence(std::memory_order_release);
+        record.sequence = 0;
+        slot = record;
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.sequence = index + 1;
+        header_->head.store(index + 1, std::memory_order_release);
+    }
+    
+    // Same format as a mapped file
+    bool Dump(const std::string& path, std::string& error) const;
+    
+private:
+    TraceHeader* header_;
+    TraceRecord* records_;
+    
+    // In-memory ring, used until MapFile() succeeds
+    TraceHeader memory_header_ = {};
+    TraceRecord memory_records_[kMemoryRecords] = {};
+    
+    void* mapping_ = nullptr;       // header of the mapped file
+#ifdef _WIN32
+    HANDLE file_mapping_ = nullptr;
+#endif
+};
+
+// Copies the valid records of a ring in order, oldest first
+size_t ReadTrace(const TraceHeader& header, const TraceRecord* records, TraceRecord* out, size_t max_records);
@@ -0,0 +1,51 @@
+#include "trace.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+constexpr size_t kFileSize = sizeof(TraceHeader) + sizeof(TraceRecord) * TraceRing::kFileRecords;
+}
+
+TraceRing::~TraceRing() {
+    if (mapping_) {
+        munmap(mapping_, kFileSize);
+    }
+}
+
+bool TraceRing::MapFile(const std::string& path, std::string& error) {
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        error = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    
+    // Pages are written back by the kernel, also after a crash
+    struct stat info;
+    bool sized = fstat(fd, &info) == 0 && (static_cast<size_t>(info.st_size) == kFileSize ||
+                                          ftruncate(fd, kFileSize) == 0);
+    void* memory = sized ? mmap(nullptr, kFileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (memory == MAP_FAILED) {
+        error = "cannot map " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    
+    // A trace from an earlier run carries on where it ended
+    auto* header = static_cast<TraceHeader*>(memory);
+    if (header->magic != TraceHeader::kMagic || header->version != TraceHeader::kVersion ||
+        header->record_size != sizeof(TraceRecord) || header->capacity != kFileRecords) {
+        std::memset(memory, 0, kFileSize);
+        header->magic = TraceHeader::kMagic;
+        header->version = TraceHeader::kVersion;
+        header->record_size = sizeof(TraceRecord);
+        header->capacity = kFileRecords;
+    }
+    mapping_ = memory;
+    header_ = header;
+    records_ = reinterpret_cast<TraceRecord*>(header + 1);
+    return true;
+}
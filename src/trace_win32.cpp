@@ -0,0 +1,61 @@
+#include "trace.h"
+
+namespace {
+constexpr DWORD kFileSize = sizeof(TraceHeader) + sizeof(TraceRecord) * TraceRing::kFileRecords;
+
+std::wstring Utf8ToWide(const std::string& text) {
+    int size = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, nullptr, 0);
+    std::wstring wide(size - 1, 0);
+    MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, &wide[0], size);
+    return wide;
+}
+}
+
+TraceRing::~TraceRing() {
+    if (mapping_) {
+        UnmapViewOfFile(mapping_);
+    }
+    if (file_mapping_) {
+        CloseHandle(file_mapping_);
+    }
+}
+
+bool TraceRing::MapFile(const std::string& path, std::string& error) {
+    HANDLE file = CreateFileW(Utf8ToWide(path).c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                              nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + path + " (" + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+    
+    // The section grows the file to its size; the cache manager writes the
+    // pages back, also after a crash
+    LARGE_INTEGER size;
+    bool existing = GetFileSizeEx(file, &size) && size.QuadPart == kFileSize;
+    file_mapping_ = CreateFileMappingW(file, nullptr, PAGE_READWRITE, 0, kFileSize, nullptr);
+    CloseHandle(file);
+    void* memory = file_mapping_ ? MapViewOfFile(file_mapping_, FILE_MAP_WRITE, 0, 0, kFileSize) : nullptr;
+    if (!memory) {
+        error = "cannot map " + path + " (" + std::to_string(GetLastError()) + ")";
+        if (file_mapping_) {
+            CloseHandle(file_mapping_);
+            file_mapping_ = nullptr;
+        }
+        return false;
+    }
+    
+    // A trace from an earlier run carries on where it ended
+    auto* header = static_cast<TraceHeader*>(memory);
+    if (!existing || header->magic != TraceHeader::kMagic || header->version != TraceHeader::kVersion ||
+        header->record_size != sizeof(TraceRecord) || header->capacity != TraceRing::kFileRecords) {
+        ZeroMemory(memory, kFileSize);
+        header->magic = TraceHeader::kMagic;
+        header->version = TraceHeader::kVersion;
+        header->record_size = sizeof(TraceRecord);
+        header->capacity = TraceRing::kFileRecords;
+    }
+    mapping_ = memory;
+    header_ = header;
+    records_ = reinterpret_cast<TraceRecord*>(header + 1);
+    return true;
+}
@@ -0,0 +1,49 @@
+#include "tray_tooltip.h"
+#include <cstdio>
+#include <cstring>
+
+namespace {
+const char* kStatusText[] = {
+    "Mouse Mover - Active",
+    "Mouse Mover - Paused",
+    "Mouse Mover - Off schedule",
+    "Mouse Mover - Session away",
+};
+
+// The text is ASCII, so widening is a plain copy
+size_t Widen(const char* text, size_t length, wchar_t* buffer, size_t size) {
+    if (!size) {
+        return 0;
+    }
+    if (length >= size) {
+        length = size - 1;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        buffer[i] = static_cast<wchar_t>(text[i]);
+    }
+    buffer[length] = L'\0';
+    return length;
+}
+}
+
+size_t FormatTrayTooltip(TrayState state, const Config& config, bool power_request, const Stats* stats,
+                         wchar_t* buffer, size_t size) {
+    const char* status = kStatusText[static_cast<int>(state)];
+    
+    // Optional second line with the headline counters
+    char summary[64] = "";
+    if (stats && !power_request) {
+        stats->FormatSummary(summary, sizeof(summary));
+    }
+    
+    char text[256];
+    int length = power_request ? std::snprintf(text, sizeof(text), "%s (Power request)", status)
+               : config.auto_mode ? std::snprintf(text, sizeof(text), "%s (Auto, margin: %ds)%s%s", status,
+                                                  config.auto_margin, summary[0] ? "\n" : "", summary)
+               : std::snprintf(text, sizeof(text), "%s (Move: %ds, Wait: %ds)%s%s", status, config.short_delay,
+                               config.long_delay, summary[0] ? "\n" : "", summary);
+    if (length < 0 || static_cast<size_t>(length) >= size || static_cast<size_t>(length) >= sizeof(text)) {
+        return Widen(status, std::strlen(status), buffer, size);
+    }
+    return Widen(text, static_cast<size_t>(length), buffer, size);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "config.h"
+#include "stats.h"
+#include <cstddef>
+
+// What the first tooltip line says the mover is doing
+enum class TrayState {
+    kActive,
+    kPaused,
+    kOffSchedule,
+    kAway,
+};
+
+// Tray tooltip, e.g. "Mouse Mover - Active (Move: 5s, Wait: 30s)", with
+// the stats summary as a second line if `stats` is given. Formats straight
+// into the caller's buffer (NOTIFYICONDATA::szTip) without allocating;
+// if the details do not fit, only the status is kept. Returns the length.
+size_t FormatTrayTooltip(TrayState state, const Config& config, bool power_request, const Stats* stats,
+                         wchar_t* buffer, size_t size);
@@ -0,0 +1,172 @@
+#include "win32_input_backend.h"
+#include <powrprof.h>
+
+namespace {
+// Last-input timestamps up to this long after our own SendInput are ours
+constexpr DWORD kInjectionSlackMs = 50;
+
+// Power setting GUIDs, defined here rather than through initguid.h
+const GUID kVideoSubgroup = { 0x7516b95f, 0xf776, 0x4464, { 0x8c, 0x53, 0x06, 0x16, 0x7f, 0x40, 0xcc, 0x99 } };
+const GUID kVideoPowerdownTimeout = { 0x3c0bc021, 0xc8a8, 0x4e07, { 0xa9, 0x73, 0x6b, 0x14, 0xcb, 0xcb, 0x2b, 0x7e } };
+const GUID kSleepSubgroup = { 0x238c9fa8, 0x0aad, 0x41ed, { 0x83, 0xf4, 0x97, 0xbe, 0x24, 0x2c, 0x8f, 0x20 } };
+const GUID kStandbyTimeout = { 0x29f6c1db, 0x86da, 0x48c5, { 0x9f, 0xdb, 0xf2, 0xb6, 0x7b, 0x1f, 0x44, 0xda } };
+
+// Keeps the smaller of two timeouts in seconds, 0 meaning none
+void KeepEarliest(DWORD& earliest, DWORD seconds) {
+    if (seconds && (!earliest || seconds < earliest)) {
+        earliest = seconds;
+    }
+}
+
+struct MonitorList {
+    ScreenRect rects[MonitorLayout::kMaxMonitors];
+    int count = 0;
+};
+
+BOOL CALLBACK CollectMonitor(HMONITOR monitor, HDC dc, LPRECT rect, LPARAM data) {
+    auto* list = reinterpret_cast<MonitorList*>(data);
+    ScreenRect& bounds = list->rects[list->count++];
+    bounds.left = rect->left;
+    bounds.top = rect->top;
+    bounds.right = rect->right;
+    bounds.bottom = rect->bottom;
+    return list->count < MonitorLayout::kMaxMonitors;
+}
+}
+
+Win32InputBackend::Win32InputBackend() {
+    LASTINPUTINFO info = { sizeof(LASTINPUTINFO) };
+    last_user_tick_ = GetLastInputInfo(&info) ? info.dwTime : GetTickCount();
+    RefreshMonitors();
+}
+
+bool Win32InputBackend::GetCursorPosition(int& x, int& y) {
+    POINT pos;
+    if (!GetCursorPos(&pos)) {
+        return false;
+    }
+    x = pos.x;
+    y = pos.y;
+    return true;
+}
+
+bool Win32InputBackend::MoveCursorRelative(int dx, int dy) {
+    INPUT input = {};
+    input.type = INPUT_MOUSE;
+    input.mi.dwFlags = MOUSEEVENTF_MOVE;
+    input.mi.dx = dx;
+    input.mi.dy = dy;
+    
+    injection_begin_ = GetTickCount();
+    UINT sent = SendInput(1, &input, sizeof(INPUT));
+    injection_end_ = GetTickCount() + kInjectionSlackMs;
+    has_injected_ = true;
+    
+    return sent == 1;
+}
+
+bool Win32InputBackend::NudgeCursor(int x, int y, int dx, int dy) {
+    INPUT inputs[2] = {};
+    SetAbsoluteMove(inputs[0], x + dx, y + dy);
+    SetAbsoluteMove(inputs[1], x, y);
+    
+    // Both positions go in a single call, so nothing can interleave with them
+    injection_begin_ = GetTickCount();
+    UINT sent = SendInput(2, inputs, sizeof(INPUT));
+    injection_end_ = GetTickCount() + kInjectionSlackMs;
+    has_injected_ = true;
+    
+    return sent == 2;
+}
+
+ScreenRect Win32InputBackend::GetMonitorBounds(int x, int y) {
+    return monitors_.Find(x, y);
+}
+
+void Win32InputBackend::RefreshMonitors() {
+    // Virtual-desktop coordinates; physical pixels once the process is DPI aware
+    MonitorList list;
+    EnumDisplayMonitors(nullptr, nullptr, &CollectMonitor, reinterpret_cast<LPARAM>(&list));
+    if (!list.count) {
+        list.rects[0] = { 0, 0, GetSystemMetrics(SM_CXSCREEN), GetSystemMetrics(SM_CYSCREEN) };
+        list.count = 1;
+    }
+    monitors_.Assign(list.rects, list.count);
+    
+    virtual_desktop_.left = GetSystemMetrics(SM_XVIRTUALSCREEN);
+    virtual_desktop_.top = GetSystemMetrics(SM_YVIRTUALSCREEN);
+    virtual_desktop_.right = virtual_desktop_.left + GetSystemMetrics(SM_CXVIRTUALSCREEN);
+    virtual_desktop_.bottom = virtual_desktop_.top + GetSystemMetrics(SM_CYVIRTUALSCREEN);
+}
+
+void Win32InputBackend::SetAbsoluteMove(INPUT& input, int x, int y) const {
+    // Absolute coordinates span 0-65535 across the virtual desktop; rounding
+    // up makes Windows' scaling back to pixels land exactly on (x, y)
+    LONGLONG width = virtual_desktop_.right - virtual_desktop_.left;
+    LONGLONG height = virtual_desktop_.bottom - virtual_desktop_.top;
+    
+    input.type = INPUT_MOUSE;
+    input.mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_VIRTUALDESK;
+    input.mi.dx = static_cast<LONG>(((x - virtual_desktop_.left) * 65536LL + width - 1) / width);
+    input.mi.dy = static_cast<LONG>(((y - virtual_desktop_.top) * 65536LL + height - 1) / height);
+}
+
+bool Win32InputBackend::EnableInputHooks(Histogram* cost_ns) {
+    return hooks_.Install(cost_ns);
+}
+
+std::chrono::milliseconds Win32InputBackend::GetUserIdleTime() {
+    // The hooks already drop injected input, so their timestamp is used as is
+    if (hooks_.IsInstalled()) {
+        DWORD elapsed = GetTickCount() - Win32InputHooks::LastInputTick();
+        // An event stamped a tick after our own read is not in the past
+        return std::chrono::milliseconds(elapsed < 0x80000000 ? elapsed : 0);
+    }
+    
+    LASTINPUTINFO info = { sizeof(LASTINPUTINFO) };
+    if (GetLastInputInfo(&info) && !IsOwnInjection(info.dwTime)) {
+        last_user_tick_ = info.dwTime;
+    }
+    // Unsigned arithmetic handles the 49.7-day tick wraparound
+    return std::chrono::milliseconds(GetTickCount() - last_user_tick_);
+}
+
+std::chrono::milliseconds Win32InputBackend::GetIdleTimeout() {
+    DWORD earliest = 0;
+    
+    BOOL saver_active = FALSE;
+    UINT saver_timeout = 0;
+    if (SystemParametersInfoW(SPI_GETSCREENSAVEACTIVE, 0, &saver_active, 0) && saver_active &&
+        SystemParametersInfoW(SPI_GETSCREENSAVETIMEOUT, 0, &saver_timeout, 0)) {
+        KeepEarliest(earliest, saver_timeout);
+    }
+    
+    // The scheme has separate values on AC and on battery
+    GUID* scheme = nullptr;
+    if (PowerGetActiveScheme(nullptr, &scheme) == ERROR_SUCCESS) {
+        SYSTEM_POWER_STATUS status;
+        bool on_battery = GetSystemPowerStatus(&status) && status.ACLineStatus == 0;
+        auto read = on_battery ? &PowerReadDCValueIndex : &PowerReadACValueIndex;
+        DWORD seconds = 0;
+        if (read(nullptr, scheme, &kVideoSubgroup, &kVideoPowerdownTimeout, &seconds) == ERROR_SUCCESS) {
+            KeepEarliest(earliest, seconds);
+        }
+        if (read(nullptr, scheme, &kSleepSubgroup, &kStandbyTimeout, &seconds) == ERROR_SUCCESS) {
+            KeepEarliest(earliest, seconds);
+        }
+        LocalFree(scheme);
+    }
+    
+    // "Interactive logon: Machine inactivity limit" locks the session
+    DWORD inactivity = 0;
+    DWORD size = sizeof(inactivity);
+    if (RegGetValueW(HKEY_LOCAL_MACHINE, L"SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\Policies\\System",
+                     L"InactivityTimeoutSecs", RRF_RT_REG_DWORD, nullptr, &inactivity, &size) == ERROR_SUCCESS) {
+        KeepEarliest(earliest, inactivity);
+    }
+    return std::chrono::seconds(earliest);
+}
+
+bool Win32InputBackend::IsOwnInjection(DWORD tick) const {
+    return has_injected_ && tick - injection_begin_ <= injection_end_ - injection_begin_;
+}
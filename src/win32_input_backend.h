@@ -0,0 +1,43 @@
+#pragma once
+
+#include "input_backend.h"
+#include "monitor_layout.h"
+#include "win32_input_hooks.h"
+#include <windows.h>
+
+// Win32 input layer: GetCursorPos/SendInput for the cursor and
+// GetLastInputInfo for idle time, which sees keyboard as well as mouse
+// input. Our own SendInput also updates the last-input tick, so input that
+// lands inside the injection window is ignored. Monitor rectangles come
+// from EnumDisplayMonitors and are cached until RefreshMonitors().
+// With input hooks enabled, idle time comes from the hooks instead.
+// Idle timeouts are the screen saver's, the active power scheme's display
+// and sleep timeouts for the current power source, and the machine
+// inactivity limit policy.
+class Win32InputBackend : public InputBackend {
+public:
+    Win32InputBackend();
+    
+    // Switches idle detection to low-level input hooks
+    bool EnableInputHooks(Histogram* cost_ns);
+    
+    bool GetCursorPosition(int& x, int& y) override;
+    bool MoveCursorRelative(int dx, int dy) override;
+    bool NudgeCursor(int x, int y, int dx, int dy) override;
+    ScreenRect GetMonitorBounds(int x, int y) override;
+    void RefreshMonitors() override;
+    std::chrono::milliseconds GetUserIdleTime() override;
+    std::chrono::milliseconds GetIdleTimeout() override;
+    
+private:
+    bool IsOwnInjection(DWORD tick) const;
+    void SetAbsoluteMove(INPUT& input, int x, int y) const;
+    
+    DWORD last_user_tick_ = 0;
+    DWORD injection_begin_ = 0;
+    DWORD injection_end_ = 0;
+    bool has_injected_ = false;
+    MonitorLayout monitors_;
+    ScreenRect virtual_desktop_;
+    Win32InputHooks hooks_;
+};
@@ -0,0 +1,82 @@
+#include "win32_input_hooks.h"
+
+std::atomic<DWORD> Win32InputHooks::last_input_tick_{0};
+Histogram* Win32InputHooks::cost_ns_ = nullptr;
+LONGLONG Win32InputHooks::counter_frequency_ = 0;
+
+Win32InputHooks::~Win32InputHooks() {
+    Uninstall();
+}
+
+bool Win32InputHooks::Install(Histogram* cost_ns) {
+    if (IsInstalled()) {
+        return true;
+    }
+    
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    counter_frequency_ = frequency.QuadPart;
+    cost_ns_ = cost_ns;
+    last_input_tick_.store(GetTickCount(), std::memory_order_relaxed);
+    
+    HINSTANCE instance = GetModuleHandle(nullptr);
+    mouse_hook_ = SetWindowsHookExW(WH_MOUSE_LL, &Win32InputHooks::MouseProc, instance, 0);
+    keyboard_hook_ = SetWindowsHookExW(WH_KEYBOARD_LL, &Win32InputHooks::KeyboardProc, instance, 0);
+    if (!mouse_hook_ || !keyboard_hook_) {
+        Uninstall();
+        return false;
+    }
+    return true;
+}
+
+void Win32InputHooks::Uninstall() {
+    if (mouse_hook_) {
+        UnhookWindowsHookEx(mouse_hook_);
+        mouse_hook_ = nullptr;
+    }
+    if (keyboard_hook_) {
+        UnhookWindowsHookEx(keyboard_hook_);
+        keyboard_hook_ = nullptr;
+    }
+}
+
+// Both callbacks sit on the system input path: a relaxed store and a
+// timing sample, nothing that can block or allocate
+LRESULT CALLBACK Win32InputHooks::MouseProc(int code, WPARAM wparam, LPARAM lparam) {
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+    
+    if (code == HC_ACTION) {
+        const auto* event = reinterpret_cast<const MSLLHOOKSTRUCT*>(lparam);
+        if (!(event->flags & LLMHF_INJECTED)) {
+            last_input_tick_.store(event->time, std::memory_order_relaxed);
+        }
+    }
+    
+    RecordCost(start);
+    return CallNextHookEx(nullptr, code, wparam, lparam);
+}
+
+LRESULT CALLBACK Win32InputHooks::KeyboardProc(int code, WPARAM wparam, LPARAM lparam) {
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+    
+    if (code == HC_ACTION) {
+        const auto* event = reinterpret_cast<const KBDLLHOOKSTRUCT*>(lparam);
+        if (!(event->flags & LLKHF_INJECTED)) {
+            last_input_tick_.store(event->time, std::memory_order_relaxed);
+        }
+    }
+    
+    RecordCost(start);
+    return CallNextHookEx(nullptr, code, wparam, lparam);
+}
+
+void Win32InputHooks::RecordCost(const LARGE_INTEGER& start) {
+    if (!cost_ns_) {
+        return;
+    }
+    LARGE_INTEGER end;
+    QueryPerformanceCounter(&end);
+    cost_ns_->Record(static_cast<uint64_t>((end.QuadPart - start.QuadPart) * 1000000000LL / counter_frequency_));
+}
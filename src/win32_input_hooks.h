@@ -0,0 +1,35 @@
+#pragma once
+
+#include "stats.h"
+#include <windows.h>
+#include <atomic>
+
+// WH_MOUSE_LL/WH_KEYBOARD_LL activity source. The hooks skip injected
+// events (ours or anyone else's), so the timestamp they publish is real
+// user input only, with no injection window to guess. Must be installed
+// from the thread that pumps messages; the callbacks run there too.
+class Win32InputHooks {
+public:
+    ~Win32InputHooks();
+    
+    // Cost of each callback is recorded in nanoseconds when a histogram is given
+    bool Install(Histogram* cost_ns);
+    void Uninstall();
+    bool IsInstalled() const { return mouse_hook_ != nullptr; }
+    
+    // GetTickCount() time of the last real input seen by the hooks
+    static DWORD LastInputTick() { return last_input_tick_.load(std::memory_order_relaxed); }
+    
+private:
+    static LRESULT CALLBACK MouseProc(int code, WPARAM wparam, LPARAM lparam);
+    static LRESULT CALLBACK KeyboardProc(int code, WPARAM wparam, LPARAM lparam);
+    static void RecordCost(const LARGE_INTEGER& start);
+    
+    // Hook procedures have no context pointer, so their state is static
+    static std::atomic<DWORD> last_input_tick_;
+    static Histogram* cost_ns_;
+    static LONGLONG counter_frequency_;
+    
+    HHOOK mouse_hook_ = nullptr;
+    HHOOK keyboard_hook_ = nullptr;
+};
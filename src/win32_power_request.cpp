@@ -0,0 +1,66 @@
+#include "win32_power_request.h"
+
+namespace {
+constexpr const wchar_t* kPolicyKey = L"SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\Policies\\System";
+constexpr const wchar_t* kReason = L"Mouse Mover keep-awake mode";
+}
+
+Win32PowerRequest::~Win32PowerRequest() {
+    Release();
+}
+
+bool Win32PowerRequest::Acquire(std::string& error) {
+    if (request_ || execution_state_set_) {
+        return true;
+    }
+    
+    if (IsInactivityLockEnforced()) {
+        error = "The machine inactivity limit policy locks the session regardless of power requests";
+        return false;
+    }
+    
+    REASON_CONTEXT reason = {};
+    reason.Version = POWER_REQUEST_CONTEXT_VERSION;
+    reason.Flags = POWER_REQUEST_CONTEXT_SIMPLE_STRING;
+    reason.Reason.SimpleReasonString = const_cast<LPWSTR>(kReason);
+    
+    HANDLE request = PowerCreateRequest(&reason);
+    if (request != INVALID_HANDLE_VALUE) {
+        if (PowerSetRequest(request, PowerRequestDisplayRequired) &&
+            PowerSetRequest(request, PowerRequestSystemRequired)) {
+            request_ = request;
+            return true;
+        }
+        CloseHandle(request);
+    }
+    
+    // Older or restricted environments: the thread execution state does the same job
+    if (SetThreadExecutionState(ES_CONTINUOUS | ES_DISPLAY_REQUIRED | ES_SYSTEM_REQUIRED)) {
+        execution_state_set_ = true;
+        return true;
+    }
+    
+    error = "Windows refused the power request";
+    return false;
+}
+
+void Win32PowerRequest::Release() {
+    if (request_) {
+        PowerClearRequest(request_, PowerRequestDisplayRequired);
+        PowerClearRequest(request_, PowerRequestSystemRequired);
+        CloseHandle(request_);
+        request_ = nullptr;
+    }
+    if (execution_state_set_) {
+        SetThreadExecutionState(ES_CONTINUOUS);
+        execution_state_set_ = false;
+    }
+}
+
+bool Win32PowerRequest::IsInactivityLockEnforced() {
+    DWORD value = 0;
+    DWORD size = sizeof(value);
+    LSTATUS status = RegGetValueW(HKEY_LOCAL_MACHINE, kPolicyKey, L"InactivityTimeoutSecs",
+                                  RRF_RT_REG_DWORD, nullptr, &value, &size);
+    return status == ERROR_SUCCESS && value > 0;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "power_request.h"
+#include <windows.h>
+
+// PowerCreateRequest with display- and system-required requests, falling
+// back to SetThreadExecutionState. The "Interactive logon: Machine
+// inactivity limit" policy locks on input idleness no matter what power
+// requests are held, so Acquire fails when it is set.
+class Win32PowerRequest : public PowerRequest {
+public:
+    ~Win32PowerRequest() override;
+    
+    bool Acquire(std::string& error) override;
+    void Release() override;
+    
+private:
+    static bool IsInactivityLockEnforced();
+    
+    HANDLE request_ = nullptr;
+    bool execution_state_set_ = false;
+};
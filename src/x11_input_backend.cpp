@@ -0,0 +1,183 @@
+#include "x11_input_backend.h"
+#include <X11/extensions/XTest.h>
+#include <X11/extensions/dpms.h>
+#include <X11/extensions/Xrandr.h>
+#include <ctime>
+
+namespace {
+// Idle resets up to this long after our own XTest event are ours
+constexpr uint64_t kInjectionSlackMs = 50;
+
+uint64_t MonotonicMilliseconds() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000 + static_cast<uint64_t>(now.tv_nsec) / 1000000;
+}
+}
+
+X11InputBackend::X11InputBackend() = default;
+
+X11InputBackend::~X11InputBackend() {
+    if (saver_info_) {
+        XFree(saver_info_);
+    }
+    if (display_) {
+        XCloseDisplay(display_);
+    }
+}
+
+bool X11InputBackend::Initialize(const char* display_name, std::string& error) {
+    display_ = XOpenDisplay(display_name);
+    if (!display_) {
+        error = "Cannot open X display";
+        return false;
+    }
+    root_ = DefaultRootWindow(display_);
+    
+    int event_base, error_base, major, minor;
+    if (!XTestQueryExtension(display_, &event_base, &error_base, &major, &minor)) {
+        error = "X server does not support the XTEST extension";
+        return false;
+    }
+    if (!XScreenSaverQueryExtension(display_, &event_base, &error_base)) {
+        error = "X server does not support the MIT-SCREEN-SAVER extension";
+        return false;
+    }
+    if (!XRRQueryExtension(display_, &randr_event_base_, &error_base)) {
+        error = "X server does not support the RANDR extension";
+        return false;
+    }
+    
+    // Layout is cached and re-read only when the server reports a change
+    XRRSelectInput(display_, root_, RRScreenChangeNotifyMask);
+    RefreshMonitors();
+    
+    // Allocated once and reused for every idle query
+    saver_info_ = XScreenSaverAllocInfo();
+    if (!saver_info_) {
+        error = "Out of memory";
+        return false;
+    }
+    
+    uint64_t now = MonotonicMilliseconds();
+    last_user_input_ = now;
+    if (XScreenSaverQueryInfo(display_, root_, saver_info_)) {
+        last_user_input_ = now - saver_info_->idle;
+    }
+    return true;
+}
+
+bool X11InputBackend::GetCursorPosition(int& x, int& y) {
+    Window root_return, child_return;
+    int win_x, win_y;
+    unsigned int mask;
+    return XQueryPointer(display_, root_, &root_return, &child_return, &x, &y, &win_x, &win_y, &mask) != False;
+}
+
+bool X11InputBackend::MoveCursorRelative(int dx, int dy) {
+    injection_begin_ = MonotonicMilliseconds();
+    bool sent = XTestFakeRelativeMotionEvent(display_, dx, dy, CurrentTime) != 0;
+    XFlush(display_);
+    injection_end_ = MonotonicMilliseconds() + kInjectionSlackMs;
+    has_injected_ = true;
+    return sent;
+}
+
+bool X11InputBackend::NudgeCursor(int x, int y, int dx, int dy) {
+    // Absolute motion on the current screen; both requests leave in one flush
+    injection_begin_ = MonotonicMilliseconds();
+    bool sent = XTestFakeMotionEvent(display_, -1, x + dx, y + dy, CurrentTime) != 0 &&
+                XTestFakeMotionEvent(display_, -1, x, y, CurrentTime) != 0;
+    XFlush(display_);
+    injection_end_ = MonotonicMilliseconds() + kInjectionSlackMs;
+    has_injected_ = true;
+    return sent;
+}
+
+ScreenRect X11InputBackend::GetMonitorBounds(int x, int y) {
+    return monitors_.Find(x, y);
+}
+
+void X11InputBackend::RefreshMonitors() {
+    ScreenRect rects[MonitorLayout::kMaxMonitors];
+    int count = 0;
+    
+    int monitor_count = 0;
+    XRRMonitorInfo* monitors = XRRGetMonitors(display_, root_, True, &monitor_count);
+    for (int i = 0; monitors && i < monitor_count && count < MonitorLayout::kMaxMonitors; ++i) {
+        rects[count++] = { monitors[i].x, monitors[i].y,
+                           monitors[i].x + monitors[i].width, monitors[i].y + monitors[i].height };
+    }
+    if (monitors) {
+        XRRFreeMonitors(monitors);
+    }
+    
+    // No active monitors reported (e.g. a bare Xvfb): use the whole screen
+    if (!count) {
+        int screen = DefaultScreen(display_);
+        rects[count++] = { 0, 0, DisplayWidth(display_, screen), DisplayHeight(display_, screen) };
+    }
+    monitors_.Assign(rects, count);
+}
+
+int X11InputBackend::ConnectionFd() const {
+    return ConnectionNumber(display_);
+}
+
+void X11InputBackend::ProcessEvents(bool read_socket) {
+    bool layout_changed = false;
+    while (XEventsQueued(display_, read_socket ? QueuedAfterReading : QueuedAlready) > 0) {
+        XEvent event;
+        XNextEvent(display_, &event);
+        XRRUpdateConfiguration(&event);
+        if (event.type == randr_event_base_ + RRScreenChangeNotify) {
+            layout_changed = true;
+        }
+    }
+    if (layout_changed) {
+        RefreshMonitors();
+    }
+}
+
+std::chrono::milliseconds X11InputBackend::GetUserIdleTime() {
+    uint64_t now = MonotonicMilliseconds();
+    if (XScreenSaverQueryInfo(display_, root_, saver_info_)) {
+        uint64_t last_input = now - saver_info_->idle;
+        if (!IsOwnInjection(last_input)) {
+            last_user_input_ = last_input;
+        }
+    }
+    return std::chrono::milliseconds(now - last_user_input_);
+}
+
+void X11InputBackend::SuspendScreenSaver(bool suspend) {
+    XScreenSaverSuspend(display_, suspend ? True : False);
+    XFlush(display_);
+}
+
+std::chrono::milliseconds X11InputBackend::GetIdleTimeout() {
+    int timeout = 0;
+    int interval, prefer_blanking, allow_exposures;
+    XGetScreenSaver(display_, &timeout, &interval, &prefer_blanking, &allow_exposures);
+    int earliest = timeout > 0 ? timeout : 0;
+    
+    // DPMS stages count only while DPMS is enabled; 0 disables a stage
+    int event_base, error_base;
+    CARD16 power_level;
+    BOOL enabled = False;
+    if (DPMSQueryExtension(display_, &event_base, &error_base) && DPMSCapable(display_) &&
+        DPMSInfo(display_, &power_level, &enabled) && enabled) {
+        CARD16 stages[3];
+        DPMSGetTimeouts(display_, &stages[0], &stages[1], &stages[2]);
+        for (CARD16 seconds : stages) {
+            if (seconds && (!earliest || seconds < earliest)) {
+                earliest = seconds;
+            }
+        }
+    }
+    return std::chrono::seconds(earliest);
+}
+
+bool X11InputBackend::IsOwnInjection(uint64_t time) const {
+    return has_injected_ && time >= injection_begin_ && time <= injection_end_;
+}
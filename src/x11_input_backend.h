@@ -0,0 +1,59 @@
+#pragma once
+
+#include "input_backend.h"
+#include "monitor_layout.h"
+#include <cstdint>
+#include <string>
+#include <X11/Xlib.h>
+#include <X11/extensions/scrnsaver.h>
+
+// X11 input layer: XTest for synthetic input, MIT-SCREEN-SAVER for idle
+// time and RandR 1.5 monitors for geometry, re-read on RandR screen change
+// events. Everything goes over the existing
+// display connection; nothing is spawned at runtime. XTest events reset the
+// server's idle counter, so input landing inside our injection window is
+// ignored, like on Windows. Idle timeouts are the screen saver's, which
+// X lockers hook into, and the DPMS ones.
+class X11InputBackend : public InputBackend {
+public:
+    X11InputBackend();
+    ~X11InputBackend() override;
+    X11InputBackend(const X11InputBackend&) = delete;
+    X11InputBackend& operator=(const X11InputBackend&) = delete;
+    
+    // Connects to the display (nullptr means $DISPLAY) and checks extensions
+    bool Initialize(const char* display_name, std::string& error);
+    
+    bool GetCursorPosition(int& x, int& y) override;
+    bool MoveCursorRelative(int dx, int dy) override;
+    bool NudgeCursor(int x, int y, int dx, int dy) override;
+    ScreenRect GetMonitorBounds(int x, int y) override;
+    void RefreshMonitors() override;
+    std::chrono::milliseconds GetUserIdleTime() override;
+    std::chrono::milliseconds GetIdleTimeout() override;
+    
+    // Display connection for the reactor, and handling of what arrives on
+    // it. Xlib may queue events while reading a reply without the fd ever
+    // turning readable; read_socket = false handles just those.
+    int ConnectionFd() const;
+    void ProcessEvents(bool read_socket);
+    
+    // Stops the X screen saver and DPMS from kicking in, which is what X
+    // screen lockers hook into
+    void SuspendScreenSaver(bool suspend);
+    
+private:
+    bool IsOwnInjection(uint64_t time) const;
+    
+    Display* display_ = nullptr;
+    Window root_ = 0;
+    XScreenSaverInfo* saver_info_ = nullptr;
+    int randr_event_base_ = 0;
+    MonitorLayout monitors_;
+    
+    // Milliseconds on CLOCK_MONOTONIC
+    uint64_t last_user_input_ = 0;
+    uint64_t injection_begin_ = 0;
+    uint64_t injection_end_ = 0;
+    bool has_injected_ = false;
+};
@@ -0,0 +1,258 @@
+// Steady-state allocation check.
+//
+// Runs what a long-running mm does on its reactor thread over simulated
+// hours and fails if any of it touches the heap once startup is over:
+//   tick            AppController's mouse and schedule timers: wakeup
+//                   stats, MouseEngine::Tick, the trace and status records
+//   tooltip         tray tooltip and statistics text, as the tray and
+//                   SIGUSR2 format them
+//   pause           pause and resume toggles, with a nudge on the way
+//   transition      schedule window and power source changes that
+//                   republish the effective configuration
+//
+// Startup may allocate; after it the allocation count has to stay where
+// it is. The desktop is simulated (simulation.h) and the power source
+// cycles on its own, so nothing real is touched and no status page of a
+// running instance is overwritten. Exits with 1 and names the phase of
+// the first allocation.
+
+#include "app_controller.h"
+#include "config.h"
+#include "mouse_engine.h"
+#include "simulation.h"
+#include "status_page.h"
+#include "timer_wheel.h"
+#include "trace.h"
+#include "tray_tooltip.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+// Every heap allocation in this process goes through here
+namespace {
+uint64_t g_allocations = 0;
+bool g_steady = false;                  // startup is over
+const char* g_phase = "startup";        // what the reactor thread is doing
+const char* g_first_phase = nullptr;    // of the first steady-state allocation
+}
+
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    if (g_steady && !g_first_phase) {
+        g_first_phase = g_phase;
+    }
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+namespace {
+constexpr uint64_t kMinuteMs = 60000;
+constexpr uint64_t kHourMs = 3600000;
+
+// Windows that open and close through the simulated day, with their own
+// profile, and power profiles to switch between. The file does not exist,
+// so a user's mm.conf cannot change the run.
+const char kCommandLine[] =
+    "--config alloc_check.missing.conf -s 5 -l 30 -d 5 --stats --schedule daily@00:00-06:00,s=10 --schedule daily@09:00-17:30,gesture=1 "
+    "--battery s=20,l=120,slack=25 --saver s=60,gesture=1";
+
+void PrintUsage() {
+    std::fprintf(stderr,
+                 "usage: alloc_check [--hours N]\n"
+                 "  --hours N   simulated time after startup (default 24)\n");
+}
+
+// The reactor-thread state of the app: AppController with its timers on a
+// wheel driven by the virtual clock, and the tray's timers next to it
+class SteadyState : private AppController::Host {
+public:
+    SteadyState(const ActivityTrace& activity, std::time_t wall_start)
+        : clock_(wall_start),
+          backend_(clock_, activity, 15 * kMinuteMs),
+          wheel_(0) {}
+    
+    ~SteadyState() override {
+        controller_.Stop();
+        wheel_.Cancel(tooltip_timer_);
+        wheel_.Cancel(pause_timer_);
+        wheel_.Cancel(transition_timer_);
+    }
+    
+    bool Load(std::string& error) {
+        if (controller_.Load(kCommandLine, error) != ParseResult::kOk) {
+            return false;
+        }
+        engine_ = std::make_unique<MouseEngine>(controller_.Configs(), backend_, clock_, controller_.Statistics(),
+                                                &trace_);
+        return true;
+    }
+    
+    void Start() {
+        controller_.Start(*engine_, nullptr);
+        wheel_.Schedule(tooltip_timer_, 1000);
+        wheel_.Schedule(pause_timer_, 37 * kMinuteMs);
+        wheel_.Schedule(transition_timer_, kHourMs);
+    }
+    
+    void RunUntil(uint64_t end) {
+        for (uint64_t next = wheel_.NextExpiry(); next <= end; next = wheel_.NextExpiry()) {
+            clock_.Set(next);
+            // The controller's own timers; the others name themselves
+            g_phase = "tick";
+            wheel_.Advance(next);
+        }
+    }
+    
+    uint64_t Ticks() const { return ticks_; }
+    uint64_t Transitions() const { return transitions_; }
+    uint64_t Toggles() const { return toggles_; }
+    
+private:
+    // AppController::Host
+    bool IsSessionActive() const override { return true; }
+    bool IsSessionLocked() const override { return false; }
+    PowerSource CurrentPowerSource() const override { return power_source_; }
+    std::chrono::system_clock::time_point WallNow() override {
+        return std::chrono::system_clock::from_time_t(wall_start_) + std::chrono::milliseconds(clock_.Now());
+    }
+    void SetTimerSlack(int) override {}
+    void PublishStatus(StatusSnapshot& status, const Stats&, uint64_t) override { status_ = status; }
+    void OnTicked() override { ++ticks_; }
+    void OnCalibrated(const CalibrationRecord&) override {}
+    void Report(const std::string& message) override { std::fprintf(stderr, "alloc_check: %s\n", message.c_str()); }
+    
+    static void OnTooltipTimer(void* context) {
+        auto* self = static_cast<SteadyState*>(context);
+        g_phase = "tooltip";
+        TrayState state = self->controller_.IsPaused() ? TrayState::kPaused : TrayState::kActive;
+        FormatTrayTooltip(state, self->controller_.Current(), false, &self->controller_.Statistics(), self->tooltip_,
+                          sizeof(self->tooltip_) / sizeof(self->tooltip_[0]));
+        self->controller_.Statistics().Format(self->clock_.Now(), self->stats_text_, sizeof(self->stats_text_));
+        self->wheel_.Schedule(self->tooltip_timer_, self->clock_.Now() + 1000);
+    }
+    
+    static void OnPauseTimer(void* context) {
+        auto* self = static_cast<SteadyState*>(context);
+        g_phase = "pause";
+        uint64_t now = self->clock_.Now();
+        bool paused = !self->controller_.IsPaused();
+        self->controller_.SetPaused(paused);
+        if (paused) {
+            self->wheel_.Schedule(self->pause_timer_, now + 5 * kMinuteMs);
+        } else {
+            self->engine_->Nudge(now);
+            self->wheel_.Schedule(self->pause_timer_, now + 37 * kMinuteMs);
+        }
+        ++self->toggles_;
+    }
+    
+    static void OnTransitionTimer(void* context) {
+        auto* self = static_cast<SteadyState*>(context);
+        g_phase = "transition";
+        // AC, battery, battery saver, in turn
+        self->power_source_ = static_cast<PowerSource>((static_cast<int>(self->power_source_) + 1) % 3);
+        self->controller_.UpdateEffectiveConfig();
+        self->wheel_.Schedule(self->transition_timer_, self->clock_.Now() + kHourMs);
+        ++self->transitions_;
+    }
+    
+    VirtualClock clock_;
+    std::time_t wall_start_ = clock_.WallTime();
+    SimulatedInputBackend backend_;
+    TraceRing trace_;
+    TimerWheel wheel_;
+    TimerWheel::Timer tooltip_timer_{&SteadyState::OnTooltipTimer, this};
+    TimerWheel::Timer pause_timer_{&SteadyState::OnPauseTimer, this};
+    TimerWheel::Timer transition_timer_{&SteadyState::OnTransitionTimer, this};
+    PowerSource power_source_ = PowerSource::kAc;
+    StatusSnapshot status_;
+    uint64_t ticks_ = 0;
+    uint64_t transitions_ = 0;
+    uint64_t toggles_ = 0;
+    wchar_t tooltip_[128];
+    char stats_text_[1024];
+    AppController controller_{*this, wheel_, clock_, trace_};
+    std::unique_ptr<MouseEngine> engine_;
+};
+}
+
+int main(int argc, char** argv) {
+    uint64_t hours = 24;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--hours" && i + 1 < argc) {
+                hours = std::stoull(argv[++i]);
+            } else if (arg == "-h" || arg == "--help") {
+                PrintUsage();
+                return 0;
+            } else {
+                PrintUsage();
+                return 2;
+            }
+        }
+    } catch (const std::exception&) {
+        PrintUsage();
+        return 2;
+    }
+    
+    // Startup: everything before the first idle wait, plus a first cycle
+    // of transitions so both ConfigStore slots and the scratch config have
+    // held the largest configuration once
+    uint64_t warmup = 3 * kHourMs;
+    uint64_t duration = warmup + hours * kHourMs;
+    ActivityTrace activity = ActivityTrace::Synthetic(30 * kMinuteMs, 20 * kMinuteMs, duration, 1);
+    SteadyState app(activity, std::time(nullptr));
+    std::string error;
+    if (!app.Load(error)) {
+        std::fprintf(stderr, "alloc_check: %s\n", error.c_str());
+        return 1;
+    }
+    app.Start();
+    app.RunUntil(warmup);
+    uint64_t startup_allocations = g_allocations;
+    uint64_t startup_ticks = app.Ticks();
+    
+    g_steady = true;
+    app.RunUntil(duration);
+    uint64_t steady_allocations = g_allocations - startup_allocations;
+    
+    std::printf("startup_allocations=%llu\n", (unsigned long long)startup_allocations);
+    std::printf("hours=%llu ticks=%llu toggles=%llu transitions=%llu\n", (unsigned long long)hours,
+                (unsigned long long)(app.Ticks() - startup_ticks), (unsigned long long)app.Toggles(),
+                (unsigned long long)app.Transitions());
+    std::printf("steady_allocations=%llu", (unsigned long long)steady_allocations);
+    if (steady_allocations) {
+        std::printf(" first_phase=%s result=FAIL\n", g_first_phase ? g_first_phase : "unknown");
+        return 1;
+    }
+    std::printf(" result=pass\n");
+    return 0;
+}
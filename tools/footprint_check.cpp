@@ -0,0 +1,177 @@
+// Footprint check for --footprint.
+//
+// Runs a startup that leaves its memory behind the way mm's does: the
+// configuration and help text, plus --startup-kb of heap in small blocks
+// standing in for the string conversions and icon loading, freed again
+// but pinned below a block that stays. Then it measures the process:
+//   startup         after initialization, before ReduceFootprint()
+//   reduced         right after ReduceFootprint()
+//   steady          after --hours of simulated ticks on a virtual clock
+//
+// Prints the resident set (working set) and private memory of each stage
+// in KB, and exits with 1 if ReduceFootprint() gives back less than half
+// of the startup heap, or if the steady state brings back more than
+// --max-steady-kb of it. Windows reads GetProcessMemoryInfo, Linux
+// /proc/self/statm.
+
+#include "config.h"
+#include "config_store.h"
+#include "footprint.h"
+#include "mouse_engine.h"
+#include "simulation.h"
+#include "stats.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr uint64_t kMinuteMs = 60000;
+constexpr uint64_t kHourMs = 3600000;
+constexpr size_t kBlockSize = 1024;
+
+struct Usage {
+    uint64_t resident_kb = 0;   // working set
+    uint64_t private_kb = 0;    // private bytes on Windows, resident minus shared on Linux
+};
+
+bool ReadUsage(Usage& usage) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS_EX counters = {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters),
+                              sizeof(counters))) {
+        return false;
+    }
+    usage.resident_kb = counters.WorkingSetSize / 1024;
+    usage.private_kb = counters.PrivateUsage / 1024;
+    return true;
+#else
+    FILE* file = std::fopen("/proc/self/statm", "r");
+    if (!file) {
+        return false;
+    }
+    unsigned long long size = 0;
+    unsigned long long resident = 0;
+    unsigned long long shared = 0;
+    int fields = std::fscanf(file, "%llu %llu %llu", &size, &resident, &shared);
+    std::fclose(file);
+    if (fields != 3) {
+        return false;
+    }
+    uint64_t page_kb = static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) / 1024;
+    usage.resident_kb = resident * page_kb;
+    usage.private_kb = (resident - shared) * page_kb;
+    return true;
+#endif
+}
+
+void PrintUsage(const char* stage, const Usage& usage) {
+    std::printf("stage=%s resident_kb=%llu private_kb=%llu\n", stage, (unsigned long long)usage.resident_kb,
+                (unsigned long long)usage.private_kb);
+}
+
+void PrintHelp() {
+    std::fprintf(stderr,
+                 "usage: footprint_check [--startup-kb N] [--hours N] [--max-steady-kb N]\n"
+                 "  --startup-kb N     startup-only heap to leave behind (default 8192)\n"
+                 "  --hours N          simulated steady state (default 24)\n"
+                 "  --max-steady-kb N  resident memory the steady state may bring back (default 1024)\n");
+}
+}
+
+int main(int argc, char** argv) {
+    uint64_t startup_kb = 8192;
+    uint64_t hours = 24;
+    uint64_t max_steady_kb = 1024;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--startup-kb" && i + 1 < argc) {
+                startup_kb = std::stoull(argv[++i]);
+            } else if (arg == "--hours" && i + 1 < argc) {
+                hours = std::stoull(argv[++i]);
+            } else if (arg == "--max-steady-kb" && i + 1 < argc) {
+                max_steady_kb = std::stoull(argv[++i]);
+            } else if (arg == "-h" || arg == "--help") {
+                PrintHelp();
+                return 0;
+            } else {
+                PrintHelp();
+                return 2;
+            }
+        }
+    } catch (const std::exception&) {
+        PrintHelp();
+        return 2;
+    }
+    
+    // Startup: what stays, then what is only needed once, touched and freed
+    Config config;
+    std::string error;
+    if (ParseCommandLine("-s 5 -l 30 -d 5 --footprint", config, error) != ParseResult::kOk) {
+        std::fprintf(stderr, "footprint_check: %s\n", error.c_str());
+        return 1;
+    }
+    ConfigStore store;
+    store.Publish(config);
+    uint64_t duration = hours * kHourMs;
+    ActivityTrace activity = ActivityTrace::Synthetic(30 * kMinuteMs, 20 * kMinuteMs, duration, 1);
+    VirtualClock clock;
+    SimulatedInputBackend backend(clock, activity, 15 * kMinuteMs);
+    Stats stats;
+    MouseEngine engine(store, backend, clock, stats);
+    
+    std::vector<std::unique_ptr<char[]>> startup_only;
+    std::string help = GetHelpText();
+    for (uint64_t i = 0; i < startup_kb * 1024 / kBlockSize; ++i) {
+        startup_only.emplace_back(new char[kBlockSize]);
+        std::memset(startup_only.back().get(), static_cast<int>(i), kBlockSize);
+    }
+    // Allocated last, so the heap cannot simply shrink past the freed blocks
+    std::unique_ptr<char[]> pin(new char[kBlockSize]);
+    std::memset(pin.get(), 1, kBlockSize);
+    startup_only.clear();
+    startup_only.shrink_to_fit();
+    help.clear();
+    help.shrink_to_fit();
+    
+    Usage startup;
+    Usage reduced;
+    Usage steady;
+    if (!ReadUsage(startup)) {
+        std::fprintf(stderr, "footprint_check: cannot read the memory usage\n");
+        return 1;
+    }
+    ReduceFootprint();
+    ReadUsage(reduced);
+    
+    for (uint64_t now = 0; now <= duration;) {
+        clock.Set(now);
+        now = engine.Tick(now);
+    }
+    ReadUsage(steady);
+    
+    PrintUsage("startup", startup);
+    PrintUsage("reduced", reduced);
+    PrintUsage("steady", steady);
+    
+    // The working set rather than private memory: Windows may keep the
+    // trimmed pages committed, and trimming is what --footprint is for
+    uint64_t reclaimed_kb = startup.resident_kb > reduced.resident_kb ? startup.resident_kb - reduced.resident_kb : 0;
+    uint64_t regrown_kb = steady.resident_kb > reduced.resident_kb ? steady.resident_kb - reduced.resident_kb : 0;
+    bool pass = reclaimed_kb >= startup_kb / 2 && regrown_kb <= max_steady_kb;
+    std::printf("reclaimed_kb=%llu min_reclaimed_kb=%llu regrown_kb=%llu max_steady_kb=%llu result=%s\n",
+                (unsigned long long)reclaimed_kb, (unsigned long long)(startup_kb / 2),
+                (unsigned long long)regrown_kb, (unsigned long long)max_steady_kb, pass ? "pass" : "FAIL");
+    return pass ? 0 : 1;
+}
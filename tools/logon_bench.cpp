@@ -0,0 +1,262 @@
+// Logon storm model: what starting mm costs the rest of a logon.
+//
+// One worker process per CPU burns a fixed amount of CPU, standing in for
+// the profile load, the shell and the other autostart entries a logon
+// runs. Next to them --movers processes start the way mm would, each
+// burning --startup-ms of CPU (what one mm startup costs on the target;
+// measure it there), in one of these modes:
+//   none         no movers, the baseline
+//   normal       movers at normal priority, right away
+//   efficiency   EnterEfficiencyMode() first (--efficiency)
+//   deferred     efficiency plus the randomized deferred start
+//
+// Prints one key=value line per mode: how long the logon work took, how
+// much longer that is than the baseline, and when the last mover was
+// ready.
+
+#include "footprint.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+namespace {
+using SteadyClock = std::chrono::steady_clock;
+
+struct Options {
+    int movers = 0;             // 0: four per CPU
+    uint64_t logon_ms = 2000;   // CPU each logon worker burns
+    uint64_t startup_ms = 20;   // CPU each mover startup burns
+    int start_delay = 10;       // seconds, for the deferred mode
+};
+
+// A fixed amount of work the compiler cannot drop
+uint64_t Spin(uint64_t iterations) {
+    uint64_t x = 88172645463325252ull;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+    }
+    return x;
+}
+
+uint64_t IterationsPerMs() {
+    const uint64_t probe = 20000000;
+    auto start = SteadyClock::now();
+    volatile uint64_t sink = Spin(probe);
+    (void)sink;
+    double ms = std::chrono::duration<double, std::milli>(SteadyClock::now() - start).count();
+    return static_cast<uint64_t>(probe / (ms > 0 ? ms : 1));
+}
+
+unsigned Cpus() {
+    unsigned cpus = std::thread::hardware_concurrency();
+    return cpus ? cpus : 1;
+}
+
+#ifdef _WIN32
+using Child = HANDLE;
+#else
+using Child = pid_t;
+#endif
+
+// Runs this executable with `args`; returns false if it cannot
+bool Spawn(const std::vector<std::string>& args, Child& child) {
+#ifdef _WIN32
+    wchar_t path[MAX_PATH];
+    if (!GetModuleFileNameW(nullptr, path, MAX_PATH)) {
+        return false;
+    }
+    std::wstring cmd_line = L"\"" + std::wstring(path) + L"\"";
+    for (const std::string& arg : args) {
+        cmd_line += L" " + std::wstring(arg.begin(), arg.end());
+    }
+    STARTUPINFOW startup = {sizeof(startup)};
+    PROCESS_INFORMATION process = {};
+    if (!CreateProcessW(path, &cmd_line[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &process)) {
+        return false;
+    }
+    CloseHandle(process.hThread);
+    child = process.hProcess;
+    return true;
+#else
+    std::vector<char*> argv;
+    char self[] = "/proc/self/exe";
+    argv.push_back(self);
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    return posix_spawn(&child, self, nullptr, nullptr, argv.data(), environ) == 0;
+#endif
+}
+
+// Waits for all children; `exited` gets each one's exit time in ms since
+// `start`, in the order of `children`
+void WaitAll(const std::vector<Child>& children, SteadyClock::time_point start, std::vector<double>& exited) {
+    exited.assign(children.size(), 0);
+    std::vector<bool> done(children.size(), false);
+    for (size_t remaining = children.size(); remaining; --remaining) {
+#ifdef _WIN32
+        std::vector<HANDLE> handles;
+        std::vector<size_t> index;
+        for (size_t i = 0; i < children.size(); ++i) {
+            if (!done[i]) {
+                handles.push_back(children[i]);
+                index.push_back(i);
+            }
+        }
+        DWORD result = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE, INFINITE);
+        if (result >= WAIT_OBJECT_0 + handles.size()) {
+            return;
+        }
+        size_t i = index[result - WAIT_OBJECT_0];
+        CloseHandle(children[i]);
+#else
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            return;
+        }
+        size_t i = 0;
+        while (i < children.size() && children[i] != pid) {
+            ++i;
+        }
+        if (i == children.size()) {
+            ++remaining;
+            continue;
+        }
+#endif
+        done[i] = true;
+        exited[i] = std::chrono::duration<double, std::milli>(SteadyClock::now() - start).count();
+    }
+}
+
+struct Result {
+    double logon_ms = 0;        // until the last logon worker finished
+    double ready_ms = 0;        // until the last mover finished starting
+};
+
+Result RunStorm(const char* mode, const Options& options, uint64_t per_ms) {
+    int movers = std::strcmp(mode, "none") == 0 ? 0 : options.movers;
+    unsigned cpus = Cpus();
+    std::vector<Child> children;
+    auto start = SteadyClock::now();
+    
+    // Movers first: autostart launches them with the rest of the logon
+    for (int i = 0; i < movers; ++i) {
+        Child child;
+        if (Spawn({"--mover", mode, std::to_string(options.startup_ms * per_ms), std::to_string(options.start_delay),
+                   std::to_string(i)}, child)) {
+            children.push_back(child);
+        }
+    }
+    size_t first_worker = children.size();
+    for (unsigned i = 0; i < cpus; ++i) {
+        Child child;
+        if (Spawn({"--worker", std::to_string(options.logon_ms * per_ms)}, child)) {
+            children.push_back(child);
+        }
+    }
+    
+    std::vector<double> exited;
+    WaitAll(children, start, exited);
+    Result result;
+    for (size_t i = 0; i < exited.size(); ++i) {
+        double& slot = i < first_worker ? result.ready_ms : result.logon_ms;
+        slot = exited[i] > slot ? exited[i] : slot;
+    }
+    return result;
+}
+
+// A mover's startup in the given mode
+int RunMover(const char* mode, uint64_t iterations, int start_delay, uint64_t seed) {
+    if (std::strcmp(mode, "normal") != 0) {
+        EnterEfficiencyMode();
+    }
+    if (std::strcmp(mode, "deferred") == 0) {
+        // The apps take long_delay as a cap as well; 30 s is the default
+        uint64_t delay = DeferredStartMs(start_delay, 30, seed);
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+    }
+    volatile uint64_t sink = Spin(iterations);
+    (void)sink;
+    return 0;
+}
+
+void PrintUsage() {
+    std::fprintf(stderr,
+                 "usage: logon_bench [--movers N] [--logon-ms N] [--startup-ms N] [--start-delay S]\n"
+                 "  --movers N       mm instances starting with the logon (default: 4 per CPU)\n"
+                 "  --logon-ms N     CPU time of the logon work per CPU (default 2000)\n"
+                 "  --startup-ms N   CPU time of one mm startup (default 20)\n"
+                 "  --start-delay S  spread of the deferred start in seconds (default 10)\n");
+}
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && std::strcmp(argv[1], "--worker") == 0) {
+        volatile uint64_t sink = Spin(std::strtoull(argv[2], nullptr, 10));
+        (void)sink;
+        return 0;
+    }
+    if (argc >= 6 && std::strcmp(argv[1], "--mover") == 0) {
+        return RunMover(argv[2], std::strtoull(argv[3], nullptr, 10), std::atoi(argv[4]),
+                        std::strtoull(argv[5], nullptr, 10));
+    }
+    
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--movers") == 0 && has_value) {
+            options.movers = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--logon-ms") == 0 && has_value) {
+            options.logon_ms = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--startup-ms") == 0 && has_value) {
+            options.startup_ms = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--start-delay") == 0 && has_value) {
+            options.start_delay = std::atoi(argv[++i]);
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+    if (options.movers <= 0) {
+        options.movers = static_cast<int>(4 * Cpus());
+    }
+#ifdef _WIN32
+    // WaitForMultipleObjects takes at most 64 handles
+    if (options.movers + Cpus() > MAXIMUM_WAIT_OBJECTS) {
+        options.movers = static_cast<int>(MAXIMUM_WAIT_OBJECTS - Cpus());
+    }
+#endif
+
+    uint64_t per_ms = IterationsPerMs();
+    std::printf("cpus=%u movers=%d logon_ms=%llu startup_ms=%llu start_delay=%d\n", Cpus(), options.movers,
+                (unsigned long long)options.logon_ms, (unsigned long long)options.startup_ms, options.start_delay);
+    
+    double baseline = 0;
+    for (const char* mode : {"none", "normal", "efficiency", "deferred"}) {
+        Result result = RunStorm(mode, options, per_ms);
+        if (std::strcmp(mode, "none") == 0) {
+            baseline = result.logon_ms;
+        }
+        std::printf("mode=%s logon_ms=%.0f slowdown=%.1f%% movers_ready_ms=%.0f\n", mode, result.logon_ms,
+                    baseline > 0 ? (result.logon_ms / baseline - 1) * 100 : 0.0, result.ready_ms);
+    }
+    return 0;
+}
@@ -0,0 +1,507 @@
+// Microbenchmarks with regression thresholds.
+//
+// Times the paths that run while mm is up or starting, on stub OS layers
+// that count every call the code under test makes:
+//   tick.*          one MouseEngine::Tick per decision outcome
+//   parse.*         ParseCommandLine plus ValidateConfig
+//   tooltip.*       FormatTrayTooltip, as UpdateTrayTooltip runs it
+//   startup.*       a fresh process from exec to the first idle wait: parse,
+//                   publish, first tick (the mover core, without tray or X)
+//   control.*       pause and resume from another thread to the toggle taking
+//                   effect on a real reactor that sleeps with an hour-long
+//                   mouse timer armed
+//   legacy.*        the same paths in legacy/main.cpp, Windows only, as the
+//                   A/B baseline
+//
+// Prints one key=value line per benchmark: nanoseconds, heap allocations
+// and OS calls per operation, the thresholds and pass/fail. Exits with 1
+// if any benchmark is over a threshold. Allocations and OS calls are
+// deterministic and their thresholds exact, so a change that adds either
+// to a hot path fails right away; time thresholds leave room for slow CI
+// machines and only catch gross regressions.
+
+#include "app_controller.h"
+#include "clock.h"
+#include "config.h"
+#include "config_store.h"
+#include "input_backend.h"
+#include "mouse_engine.h"
+#include "reactor.h"
+#include "stats.h"
+#include "trace.h"
+#include "tray_tooltip.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/eventfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+// Every heap allocation in this process goes through here
+namespace {
+uint64_t g_allocations = 0;
+}
+
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+#ifdef _WIN32
+// legacy/main.cpp with its OS calls stubbed out, see mmbench_legacy.cpp
+namespace legacy_baseline {
+bool ParseCommandLine(const char* cmd_line);
+void MoveMouse();
+void FormatTooltip();
+uint64_t OsCalls();
+}
+#endif
+
+namespace {
+const char kCommandLine[] = "-s 5 -l 30 -d 5 --gesture --slack 10 --stats";
+
+// Reports what the production backend would ask the OS, without asking
+class StubBackend : public InputBackend {
+public:
+    uint64_t idle_ms = 0;
+    uint64_t calls = 0;
+    
+    bool GetCursorPosition(int& x, int& y) override {
+        ++calls;
+        x = 960;
+        y = 540;
+        return true;
+    }
+    bool MoveCursorRelative(int, int) override { ++calls; return true; }
+    bool NudgeCursor(int, int, int, int) override { ++calls; return true; }
+    ScreenRect GetMonitorBounds(int, int) override { ++calls; return {0, 0, 1920, 1080}; }
+    void RefreshMonitors() override { ++calls; }
+    std::chrono::milliseconds GetUserIdleTime() override { ++calls; return std::chrono::milliseconds(idle_ms); }
+    std::chrono::milliseconds GetIdleTimeout() override { ++calls; return std::chrono::milliseconds(0); }
+};
+
+class StubClock : public Clock {
+public:
+    uint64_t calls = 0;
+    
+    uint64_t Now() override { ++calls; return 0; }
+    std::time_t WallTime() override { ++calls; return 0; }
+};
+
+// Per operation; time limits are generous, the others exact. The legacy
+// baseline has none.
+struct Threshold {
+    const char* name;
+    double max_ns;
+    double max_allocations;
+    double max_os_calls;
+};
+
+constexpr Threshold kThresholds[] = {
+    {"tick.move", 2000, 0, 4},
+    {"tick.gesture", 2000, 0, 4},
+    {"tick.user_active", 1000, 0, 1},
+    {"tick.waiting", 1000, 0, 1},
+    {"parse.command_line", 200000, 2, 0},
+    {"tooltip.format", 20000, 0, 0},
+    {"startup.first_wait", 50000000, 2, 1},
+    {"control.pause_resume", 1000000, 0, 1},
+};
+
+struct Measurement {
+    double ns = 0;
+    double allocations = 0;
+    double os_calls = 0;
+};
+
+// Best of three runs of `iterations` operations; `os_calls` reads the stub
+// counters
+template <typename Operation, typename OsCalls>
+Measurement Measure(uint64_t iterations, Operation operation, OsCalls os_calls) {
+    Measurement best;
+    for (int run = 0; run < 3; ++run) {
+        uint64_t allocations = g_allocations;
+        uint64_t calls = os_calls();
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) {
+            operation();
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0 || ns / iterations < best.ns) {
+            best.ns = ns / iterations;
+        }
+        best.allocations = static_cast<double>(g_allocations - allocations) / iterations;
+        best.os_calls = static_cast<double>(os_calls() - calls) / iterations;
+    }
+    return best;
+}
+
+int g_failures = 0;
+
+void Report(const char* name, const Measurement& measurement) {
+    std::printf("name=%s ns=%.1f allocations=%.2f os_calls=%.2f", name, measurement.ns, measurement.allocations,
+                measurement.os_calls);
+    const Threshold* threshold = std::find_if(std::begin(kThresholds), std::end(kThresholds),
+                                              [name](const Threshold& t) { return std::strcmp(t.name, name) == 0; });
+    if (threshold == std::end(kThresholds)) {
+        std::printf(" result=baseline\n");
+        return;
+    }
+    bool pass = measurement.ns <= threshold->max_ns && measurement.allocations <= threshold->max_allocations &&
+                measurement.os_calls <= threshold->max_os_calls;
+    g_failures += !pass;
+    std::printf(" max_ns=%.0f max_allocations=%.0f max_os_calls=%.0f result=%s\n", threshold->max_ns,
+                threshold->max_allocations, threshold->max_os_calls, pass ? "pass" : "FAIL");
+}
+
+// The decision for one tick, with the user idle for `idle_ms`; `step_ms`
+// advances the clock per tick
+Measurement MeasureTick(bool gesture, uint64_t idle_ms, uint64_t step_ms) {
+    Config config;
+    config.gesture = gesture;
+    ConfigStore store;
+    store.Publish(config);
+    StubBackend backend;
+    backend.idle_ms = idle_ms;
+    StubClock clock;
+    Stats stats;
+    MouseEngine engine(store, backend, clock, stats);
+    
+    // Starts with a move, so an early wakeup has one to wait after
+    uint64_t now = 3600000;
+    engine.Tick(now);
+    return Measure(2000000, [&] { engine.Tick(now += step_ms); },
+                   [&] { return backend.calls + clock.calls; });
+}
+
+Measurement MeasureParse() {
+    return Measure(20000, [] {
+        Config config;
+        std::string error;
+        ParseCommandLine(kCommandLine, config, error);
+        ValidateConfig(config, error);
+    }, [] { return uint64_t(0); });
+}
+
+Measurement MeasureTooltip() {
+    Config config;
+    config.show_stats = true;
+    Stats stats;
+    stats.inject_calls = 12345;
+    stats.wakeups = 23456;
+    wchar_t tip[128];
+    return Measure(200000, [&] {
+        FormatTrayTooltip(TrayState::kActive, config, false, &stats, tip, sizeof(tip) / sizeof(tip[0]));
+    }, [] { return uint64_t(0); });
+}
+
+// Pause and resume as the tray, SIGUSR1 and --ctl deliver them: through a
+// handle the reactor waits on. Another thread signals once the reactor is
+// back asleep; the time runs from the signal until the toggle has taken
+// effect. The last toggle stops the reactor, as exit does. OS calls are
+// the ticks a resume makes.
+class ToggleBench : private AppController::Host {
+public:
+    explicit ToggleBench(uint64_t toggles) : toggles_(toggles) {}
+    
+    ~ToggleBench() override {
+        controller_.Stop();
+#ifdef _WIN32
+        if (signal_) {
+            CloseHandle(signal_);
+        }
+#else
+        if (signal_ >= 0) {
+            close(signal_);
+        }
+#endif
+    }
+    
+    bool Run(Measurement& measurement) {
+        // An hour between moves, so only a wakeable wait makes the toggles fast
+        std::string error;
+        if (!reactor_.Initialize() ||
+            controller_.Load("--config mmbench.missing.conf -s 3600 -l 3600", error) != ParseResult::kOk) {
+            return false;
+        }
+#ifdef _WIN32
+        signal_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (!signal_) {
+            return false;
+        }
+#else
+        signal_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (signal_ < 0) {
+            return false;
+        }
+#endif
+        if (!reactor_.AddHandle(signal_, &ToggleBench::OnSignal, this)) {
+            return false;
+        }
+        engine_ = std::make_unique<MouseEngine>(controller_.Configs(), backend_, clock_, controller_.Statistics());
+        controller_.Start(*engine_, nullptr);
+        
+        std::thread signaller(&ToggleBench::SignalLoop, this);
+        uint64_t allocations = g_allocations;
+        uint64_t calls = backend_.calls;
+        reactor_.Run();
+        measurement.ns = static_cast<double>(total_ns_) / toggles_;
+        measurement.allocations = static_cast<double>(g_allocations - allocations) / toggles_;
+        measurement.os_calls = static_cast<double>(backend_.calls - calls) / toggles_;
+        signaller.join();
+        reactor_.RemoveHandle(signal_);
+        return true;
+    }
+    
+private:
+    // AppController::Host
+    bool IsSessionActive() const override { return true; }
+    bool IsSessionLocked() const override { return false; }
+    PowerSource CurrentPowerSource() const override { return PowerSource::kAc; }
+    void SetTimerSlack(int percent) override { reactor_.SetTimerSlack(percent); }
+    void PublishStatus(StatusSnapshot&, const Stats&, uint64_t) override {}
+    void OnCalibrated(const CalibrationRecord&) override {}
+    void Report(const std::string&) override {}
+    
+    static int64_t SteadyNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    void SignalLoop() {
+        for (uint64_t i = 0; i < toggles_; ++i) {
+            // The last toggle is handled and the reactor is asleep again
+            while (handled_.load() < i) {
+                std::this_thread::yield();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            signaled_at_.store(SteadyNs());
+#ifdef _WIN32
+            SetEvent(signal_);
+#else
+            uint64_t one = 1;
+            ssize_t ignored = write(signal_, &one, sizeof(one));
+            (void)ignored;
+#endif
+        }
+    }
+    
+    static void OnSignal(void* context) {
+        auto* self = static_cast<ToggleBench*>(context);
+#ifndef _WIN32
+        uint64_t count;
+        ssize_t ignored = read(self->signal_, &count, sizeof(count));
+        (void)ignored;
+#endif
+        self->controller_.TogglePause();
+        self->total_ns_ += SteadyNs() - self->signaled_at_.load();
+        if (self->handled_.fetch_add(1) + 1 == self->toggles_) {
+            self->reactor_.Stop();
+        }
+    }
+    
+    uint64_t toggles_;
+    Reactor reactor_;
+#ifdef _WIN32
+    HANDLE signal_ = nullptr;
+#else
+    int signal_ = -1;
+#endif
+    StubBackend backend_;
+    SystemClock clock_;
+    TraceRing trace_;
+    AppController controller_{*this, reactor_.Timers(), clock_, trace_};
+    std::unique_ptr<MouseEngine> engine_;
+    std::atomic<int64_t> signaled_at_{0};
+    std::atomic<uint64_t> handled_{0};
+    int64_t total_ns_ = 0;
+};
+
+Measurement MeasureToggle() {
+    Measurement measurement;
+    ToggleBench bench(200);
+    if (!bench.Run(measurement)) {
+        measurement.ns = 1e18;
+    }
+    return measurement;
+}
+
+// What the child process does before it would first go to sleep
+int RunStartup(const char* variant) {
+#ifdef _WIN32
+    if (std::strcmp(variant, "legacy") == 0) {
+        if (!legacy_baseline::ParseCommandLine("-s 5 -l 30 -d 5")) {
+            return 1;
+        }
+        legacy_baseline::MoveMouse();
+        return static_cast<int>(2 + legacy_baseline::OsCalls());
+    }
+#else
+    (void)variant;
+#endif
+    Config config;
+    std::string error;
+    if (ParseCommandLine(kCommandLine, config, error) != ParseResult::kOk || !ValidateConfig(config, error)) {
+        return 1;
+    }
+    ConfigStore store;
+    store.Publish(config);
+    StubBackend backend;
+    StubClock clock;
+    Stats stats;
+    MouseEngine engine(store, backend, clock, stats);
+    engine.Tick(0);
+    
+    // The parent counts what reached the OS layer through the exit code
+    return static_cast<int>(2 + backend.calls + clock.calls);
+}
+
+// Runs this executable with --startup-child; returns its exit code, or -1
+int SpawnStartup(const char* variant) {
+#ifdef _WIN32
+    wchar_t path[MAX_PATH];
+    if (!GetModuleFileNameW(nullptr, path, MAX_PATH)) {
+        return -1;
+    }
+    std::wstring cmd_line = L"\"" + std::wstring(path) + L"\" --startup-child " +
+                            (std::strcmp(variant, "legacy") == 0 ? L"legacy" : L"current");
+    STARTUPINFOW startup = {sizeof(startup)};
+    PROCESS_INFORMATION process = {};
+    if (!CreateProcessW(path, &cmd_line[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &process)) {
+        return -1;
+    }
+    WaitForSingleObject(process.hProcess, INFINITE);
+    DWORD code = 0;
+    GetExitCodeProcess(process.hProcess, &code);
+    CloseHandle(process.hThread);
+    CloseHandle(process.hProcess);
+    return static_cast<int>(code);
+#else
+    char self[] = "/proc/self/exe";
+    char option[] = "--startup-child";
+    char value[16];
+    std::snprintf(value, sizeof(value), "%s", variant);
+    char* argv[] = {self, option, value, nullptr};
+    pid_t pid;
+    if (posix_spawn(&pid, self, nullptr, nullptr, argv, environ) != 0) {
+        return -1;
+    }
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+        return -1;
+    }
+    return WEXITSTATUS(status);
+#endif
+}
+
+Measurement MeasureStartup(const char* variant) {
+    int code = 0;
+    Measurement measurement = Measure(20, [&] { code = SpawnStartup(variant); }, [] { return uint64_t(0); });
+    measurement.os_calls = code >= 2 ? code - 2 : 1e9;
+    
+    // The child's allocations are not seen from here; the same steps in
+    // this process make the same ones
+    uint64_t allocations = g_allocations;
+    RunStartup(variant);
+    measurement.allocations = static_cast<double>(g_allocations - allocations);
+    return measurement;
+}
+}
+
+int main(int argc, char** argv) {
+    const char* filter = "";
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--startup-child") == 0 && i + 1 < argc) {
+            return RunStartup(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: mmbench [--filter TEXT]\n"
+                                 "  --filter TEXT  only benchmarks whose name contains TEXT\n");
+            return 2;
+        }
+    }
+    auto selected = [filter](const char* name) { return std::strstr(name, filter) != nullptr; };
+    
+    if (selected("tick.move")) {
+        Report("tick.move", MeasureTick(false, 3600000, 5000));
+    }
+    if (selected("tick.gesture")) {
+        Report("tick.gesture", MeasureTick(true, 3600000, 5000));
+    }
+    if (selected("tick.user_active")) {
+        Report("tick.user_active", MeasureTick(false, 0, 5000));
+    }
+    if (selected("tick.waiting")) {
+        Report("tick.waiting", MeasureTick(false, 3600000, 0));
+    }
+    if (selected("parse.command_line")) {
+        Report("parse.command_line", MeasureParse());
+    }
+    if (selected("tooltip.format")) {
+        Report("tooltip.format", MeasureTooltip());
+    }
+    if (selected("startup.first_wait")) {
+        Report("startup.first_wait", MeasureStartup("current"));
+    }
+    if (selected("control.pause_resume")) {
+        Report("control.pause_resume", MeasureToggle());
+    }
+
+#ifdef _WIN32
+    if (selected("legacy.tick.move")) {
+        Report("legacy.tick.move", Measure(2000000, [] { legacy_baseline::MoveMouse(); },
+                                           [] { return legacy_baseline::OsCalls(); }));
+    }
+    if (selected("legacy.parse.command_line")) {
+        Report("legacy.parse.command_line", Measure(20000, [] {
+            legacy_baseline::ParseCommandLine("-s 5 -l 30 -d 5");
+        }, [] { return legacy_baseline::OsCalls(); }));
+    }
+    if (selected("legacy.tooltip.format")) {
+        Report("legacy.tooltip.format", Measure(200000, [] { legacy_baseline::FormatTooltip(); },
+                                                [] { return legacy_baseline::OsCalls(); }));
+    }
+    if (selected("legacy.startup.first_wait")) {
+        Report("legacy.startup.first_wait", MeasureStartup("legacy"));
+    }
+#endif
+    return g_failures ? 1 : 0;
+}
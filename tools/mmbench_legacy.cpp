@@ -0,0 +1,93 @@
+// legacy/main.cpp as the A/B baseline for mmbench (Windows only).
+//
+// The legacy source is compiled unchanged inside a namespace, with the
+// Win32 calls its parser, mover and tooltip make redirected to stubs that
+// count them, so the baseline runs without a desktop and never injects
+// input. Its std::chrono reads in MoveMouse stay real, as in production.
+
+#undef UNICODE
+#undef _UNICODE
+#include <windows.h>
+#include <shellapi.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace legacy_baseline {
+uint64_t g_os_calls = 0;
+
+BOOL StubGetCursorPos(LPPOINT point) {
+    ++g_os_calls;
+    point->x = 960;
+    point->y = 540;
+    return TRUE;
+}
+
+UINT StubSendInput(UINT count, LPINPUT, int) {
+    ++g_os_calls;
+    return count;
+}
+
+int StubGetSystemMetrics(int index) {
+    ++g_os_calls;
+    return index == SM_CXSCREEN ? 1920 : 1080;
+}
+
+int StubMessageBox(HWND, LPCSTR, LPCSTR, UINT) {
+    ++g_os_calls;
+    return IDOK;
+}
+
+BOOL StubShellNotifyIcon(DWORD, PNOTIFYICONDATAA) {
+    ++g_os_calls;
+    return TRUE;
+}
+
+HICON StubLoadIcon(HINSTANCE, LPCSTR) {
+    ++g_os_calls;
+    return nullptr;
+}
+
+HMODULE StubGetModuleHandle(LPCSTR) {
+    ++g_os_calls;
+    return nullptr;
+}
+}
+
+#undef MessageBox
+#undef Shell_NotifyIcon
+#undef LoadIcon
+#undef GetModuleHandle
+#define GetCursorPos StubGetCursorPos
+#define SendInput StubSendInput
+#define GetSystemMetrics StubGetSystemMetrics
+#define MessageBox StubMessageBox
+#define Shell_NotifyIcon StubShellNotifyIcon
+#define LoadIcon StubLoadIcon
+#define GetModuleHandle StubGetModuleHandle
+
+namespace legacy_baseline {
+#include "../legacy/main.cpp"
+
+bool ParseCommandLine(const char* cmd_line) {
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer), "%s", cmd_line);
+    Config config;
+    return ParseCommandLine(buffer, config);
+}
+
+void FormatTooltip() {
+    CreateTrayIcon();
+}
+
+uint64_t OsCalls() {
+    return g_os_calls;
+}
+}
@@ -0,0 +1,215 @@
+// Activity replay for the mover's decision logic.
+//
+// Feeds a user-activity trace through the real MouseEngine on a virtual
+// clock (simulation.h) and reports what the given mover options do with
+// it: wakeups, nudges, lock deadlines missed and how long after the user's
+// last input the first nudge comes. Hours replay in milliseconds, so
+// configurations can be compared offline.
+//
+// Activity comes from a text trace (--activity), from the ticks of a
+// decision trace written by `mm --trace` (--decisions), or is synthetic:
+// typing stretches and away stretches of random length around the given
+// means. The OS locks --lock-min after the last input, the user's or ours;
+// --hidden-timeout keeps that from --auto, as for --calibrate.
+//
+// --fleet N runs N instances that start together and replay the same
+// activity, as on a VDI host after a logon storm, and compares how their
+// wakeups bunch up in time without jitter and with the given --jitter.
+
+#include "config.h"
+#include "simulation.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+
+namespace {
+constexpr uint64_t kHourMs = 3600000;
+constexpr uint64_t kMinuteMs = 60000;
+
+void PrintUsage() {
+    std::fprintf(stderr,
+                 "usage: mmsim [--activity FILE | --decisions FILE | --synthetic ACTIVE_MIN,AWAY_MIN | --idle]\n"
+                 "             [--hours N] [--lock-min N] [--hidden-timeout] [--seed N]\n"
+                 "             [--fleet N [--bucket-ms N]] [mover options]\n"
+                 "  --activity FILE   inputs as T or T1-T2 [P] per line, in seconds\n"
+                 "  --decisions FILE  inputs seen by the ticks of an mm --trace file\n"
+                 "  --synthetic A,B   typing ~A minutes, away ~B minutes (default 30,20)\n"
+                 "  --idle            no user input at all, an unattended session\n"
+                 "  --hours N         simulated time (default 8, or the length of the trace)\n"
+                 "  --lock-min N      OS lock timeout, 0 for none (default 15)\n"
+                 "  --hidden-timeout  --auto cannot read the lock timeout\n"
+                 "  --seed N          seed of the synthetic trace and the jitter (default 1)\n"
+                 "  --fleet N         N instances started together, compare their wakeups\n"
+                 "                    with and without --jitter\n"
+                 "  --bucket-ms N     time resolution of that comparison (default 100)\n"
+                 "  mover options as for mm, see mm --help\n");
+}
+
+double Seconds(uint64_t ms) {
+    return static_cast<double>(ms) / 1000.0;
+}
+
+// Wakeups of the fleet without jitter and with the configured one; the
+// peak bucket is what a hypervisor sees as a burst of CPU ready time
+int RunFleet(const Config& config, const ActivityTrace& activity, const SimulationOptions& options,
+             uint32_t instances) {
+    Config plain = config;
+    plain.jitter_percent = 0;
+    FleetResult without = SimulateFleet(plain, activity, options, instances);
+    FleetResult with = SimulateFleet(config, activity, options, instances);
+    
+    std::printf("fleet: %u instances started together, wakeups per %llu ms\n\n", instances,
+                (unsigned long long)options.wake_bucket_ms);
+    std::printf("                  jitter=0%%  jitter=%d%%\n", config.jitter_percent);
+    std::printf("peak              %9u  %9u\n", without.peak, with.peak);
+    std::printf("mean              %9.2f  %9.2f\n", without.mean, with.mean);
+    std::printf("peak/mean         %9.1f  %9.1f\n", without.mean > 0 ? without.peak / without.mean : 0.0,
+                with.mean > 0 ? with.peak / with.mean : 0.0);
+    std::printf("deviation         %9.2f  %9.2f\n", without.deviation, with.deviation);
+    std::printf("empty buckets     %8.1f%%  %8.1f%%\n", without.empty_share * 100, with.empty_share * 100);
+    std::printf("wakeups           %9llu  %9llu\n", (unsigned long long)without.wakeups,
+                (unsigned long long)with.wakeups);
+    std::printf("missed locks      %9llu  %9llu\n", (unsigned long long)without.locks,
+                (unsigned long long)with.locks);
+    if (with.peak) {
+        std::printf("\npeak flattened %.1fx\n", static_cast<double>(without.peak) / with.peak);
+    }
+    return with.locks ? 3 : 0;
+}
+}
+
+int main(int argc, char** argv) {
+    std::string activity_path;
+    std::string decisions_path;
+    uint64_t active_mean_ms = 30 * kMinuteMs;
+    uint64_t away_mean_ms = 20 * kMinuteMs;
+    uint64_t hours = 0;
+    uint64_t seed = 1;
+    bool idle = false;
+    uint32_t fleet = 0;
+    SimulationOptions options;
+    std::string mover_args;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--activity" && has_value) {
+                activity_path = argv[++i];
+            } else if (arg == "--decisions" && has_value) {
+                decisions_path = argv[++i];
+            } else if (arg == "--synthetic" && has_value) {
+                std::string means = argv[++i];
+                size_t comma = means.find(',');
+                if (comma == std::string::npos) {
+                    PrintUsage();
+                    return 2;
+                }
+                active_mean_ms = std::stoull(means.substr(0, comma)) * kMinuteMs;
+                away_mean_ms = std::stoull(means.substr(comma + 1)) * kMinuteMs;
+            } else if (arg == "--idle") {
+                idle = true;
+            } else if (arg == "--fleet" && has_value) {
+                fleet = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--bucket-ms" && has_value) {
+                options.wake_bucket_ms = std::stoull(argv[++i]);
+            } else if (arg == "--hours" && has_value) {
+                hours = std::stoull(argv[++i]);
+            } else if (arg == "--lock-min" && has_value) {
+                options.lock_timeout_ms = std::stoull(argv[++i]) * kMinuteMs;
+            } else if (arg == "--hidden-timeout") {
+                options.hide_timeout = true;
+            } else if (arg == "--seed" && has_value) {
+                seed = std::stoull(argv[++i]);
+            } else if (arg == "-h" || arg == "--help") {
+                PrintUsage();
+                return 0;
+            } else {
+                mover_args += arg + ' ';
+            }
+        }
+    } catch (const std::exception&) {
+        PrintUsage();
+        return 2;
+    }
+    if (!active_mean_ms || !away_mean_ms || !options.wake_bucket_ms) {
+        PrintUsage();
+        return 2;
+    }
+    
+    Config config;
+    std::string error;
+    if (ParseCommandLine(mover_args, config, error) != ParseResult::kOk || !ValidateConfig(config, error)) {
+        std::fprintf(stderr, "mmsim: %s\n", error.empty() ? "see mm --help for mover options" : error.c_str());
+        return 1;
+    }
+    
+    // A recorded trace runs for its own length unless told otherwise
+    ActivityTrace activity;
+    const char* source = "synthetic";
+    if (!activity_path.empty() || !decisions_path.empty()) {
+        bool loaded = activity_path.empty() ? activity.LoadDecisionTrace(decisions_path, error)
+                                            : activity.Load(activity_path, error);
+        if (!loaded) {
+            std::fprintf(stderr, "mmsim: %s\n", error.c_str());
+            return 1;
+        }
+        source = activity_path.empty() ? decisions_path.c_str() : activity_path.c_str();
+        options.duration_ms = hours ? hours * kHourMs
+                                    : (activity.inputs.empty() ? 0 : activity.inputs.back()) + options.lock_timeout_ms;
+    } else if (idle) {
+        options.duration_ms = (hours ? hours : 8) * kHourMs;
+        source = "idle";
+    } else {
+        options.duration_ms = (hours ? hours : 8) * kHourMs;
+        activity = ActivityTrace::Synthetic(active_mean_ms, away_mean_ms, options.duration_ms, seed);
+    }
+    options.wall_start = std::time(nullptr);
+    options.jitter_seed = seed;
+    
+    if (fleet) {
+        std::printf("activity: %s, %zu inputs over %.1f h, lock after %llu min\n", source, activity.inputs.size(),
+                    static_cast<double>(options.duration_ms) / kHourMs,
+                    (unsigned long long)(options.lock_timeout_ms / kMinuteMs));
+        return RunFleet(config, activity, options, fleet);
+    }
+    
+    auto started = std::chrono::steady_clock::now();
+    SimulationResult result = Simulate(config, activity, options);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    double simulated_hours = static_cast<double>(options.duration_ms) / kHourMs;
+    
+    std::printf("activity: %s, %zu inputs over %.1f h, lock after %llu min%s\n", source, activity.inputs.size(),
+                simulated_hours, (unsigned long long)(options.lock_timeout_ms / kMinuteMs),
+                options.hide_timeout ? " (hidden)" : "");
+    std::printf("mover: short_delay=%ds long_delay=%ds distance=%d gesture=%d auto=%d calibrate=%d jitter=%d%%\n",
+                config.short_delay, config.long_delay, config.distance, config.gesture, config.auto_mode,
+                config.calibrate, config.jitter_percent);
+    std::printf("replayed in %.1f ms, %.0fx real time\n\n", elapsed * 1000,
+                elapsed > 0 ? Seconds(options.duration_ms) / elapsed : 0.0);
+    
+    std::printf("wakeups          %10llu  %8.1f/h\n", (unsigned long long)result.wakeups,
+                simulated_hours > 0 ? result.wakeups / simulated_hours : 0.0);
+    std::printf("nudges           %10llu  %8.1f/h\n", (unsigned long long)result.nudges,
+                simulated_hours > 0 ? result.nudges / simulated_hours : 0.0);
+    std::printf("missed locks     %10llu\n", (unsigned long long)result.locks);
+    if (result.first_nudge_ms != UINT64_MAX) {
+        std::printf("first nudge      %10.1f s\n", Seconds(result.first_nudge_ms));
+    } else {
+        std::printf("first nudge      %10s\n", "never");
+    }
+    if (result.idle_stretches) {
+        std::printf("time to nudge    %10.1f s mean, %.1f s max over %llu idle stretches\n",
+                    Seconds(result.nudge_delay_sum_ms / result.idle_stretches), Seconds(result.nudge_delay_max_ms),
+                    (unsigned long long)result.idle_stretches);
+    }
+    std::printf("cursor           %10d px max drift, %llu moves off screen\n", result.max_drift,
+                (unsigned long long)result.out_of_bounds);
+    if (config.calibrate) {
+        std::printf("calibrated       %10u s\n", result.calibrated_timeout_s);
+    }
+    
+    // Nonzero if the configuration let the session lock
+    return result.locks ? 3 : 0;
+}
@@ -0,0 +1,182 @@
+// Status page reader.
+//
+// Scans the shared-memory status page of every running instance on the
+// host in one pass, without talking to any of them: each page is mapped
+// read-only and copied out under its seqlock.
+//
+// Windows: one page per session, Session\<id>\MouseMover-Status, for every
+// session WTSEnumerateSessions reports. Reading other users' pages needs
+// an account such as LocalSystem.
+// Linux: every /dev/shm/mm-status-<uid>-<session>, shown as
+// uid<uid>-<session>; pages whose process is gone are shown as stale.
+//
+// Working set and private memory come from the OS for each pid, so the
+// per-instance footprint across a host shows up in the same pass.
+
+#include "status_page.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <wtsapi32.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+uint64_t UnixMilliseconds() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+// Seconds from a page timestamp to now, or "-" if it has none
+std::string SecondsSince(uint64_t time, uint64_t now) {
+    if (!time) {
+        return "-";
+    }
+    long long delta = static_cast<long long>(now) - static_cast<long long>(time);
+    return std::to_string(delta / 1000);
+}
+
+void PrintHeader(bool key_value) {
+    if (!key_value) {
+        std::printf("%-10s %8s %-8s %8s %8s %8s %8s %10s %10s %8s %8s %10s\n", "owner", "pid", "state", "idle_s",
+                    "moved_s", "wake_in_s", "resume_s", "moves", "wakeups", "age_s", "ws_kb", "private_kb");
+    }
+}
+
+void PrintPage(const std::string& owner, const StatusSnapshot& status, bool stale, bool key_value) {
+    uint64_t now = UnixMilliseconds();
+    ProcessMemory memory;
+    bool has_memory = !stale && GetProcessMemory(status.pid, memory);
+    std::string working_set_kb = has_memory ? std::to_string(memory.working_set / 1024) : "-";
+    std::string private_kb = has_memory ? std::to_string(memory.private_bytes / 1024) : "-";
+    const char* state = stale ? "stale" : StatusStateName(status.state);
+    
+    // Seconds until the next wakeup and the end of a timed pause
+    std::string wake_in = status.next_wake_time ? std::to_string((static_cast<long long>(status.next_wake_time) -
+                                                                  static_cast<long long>(now)) / 1000) : "-";
+    std::string resume_in = status.resume_time ? std::to_string((static_cast<long long>(status.resume_time) -
+                                                                 static_cast<long long>(now)) / 1000) : "-";
+    
+    if (key_value) {
+        std::printf("owner=%s pid=%llu state=%s short_delay=%llu long_delay=%llu distance=%llu "
+                    "start_time=%llu update_time=%llu last_move_time=%llu last_input_time=%llu "
+                    "next_wake_time=%llu resume_time=%llu wakeups=%llu moves=%llu inject_failures=%llu "
+                    "skipped_user_active=%llu skipped_long_delay=%llu pauses=%llu paused_ms=%llu "
+                    "working_set_kb=%s private_kb=%s\n",
+                    owner.c_str(), (unsigned long long)status.pid, state,
+                    (unsigned long long)status.short_delay, (unsigned long long)status.long_delay,
+                    (unsigned long long)status.distance, (unsigned long long)status.start_time,
+                    (unsigned long long)status.update_time, (unsigned long long)status.last_move_time,
+                    (unsigned long long)status.last_input_time, (unsigned long long)status.next_wake_time,
+                    (unsigned long long)status.resume_time, (unsigned long long)status.wakeups,
+                    (unsigned long long)status.moves, (unsigned long long)status.inject_failures,
+                    (unsigned long long)status.skipped_user_active, (unsigned long long)status.skipped_long_delay,
+                    (unsigned long long)status.pauses, (unsigned long long)status.paused_ms,
+                    working_set_kb.c_str(), private_kb.c_str());
+        return;
+    }
+    std::printf("%-10s %8llu %-8s %8s %8s %8s %8s %10llu %10llu %8s %8s %10s\n", owner.c_str(),
+                (unsigned long long)status.pid, state,
+                SecondsSince(status.last_input_time, now).c_str(), SecondsSince(status.last_move_time, now).c_str(),
+                wake_in.c_str(), resume_in.c_str(), (unsigned long long)status.moves,
+                (unsigned long long)status.wakeups, SecondsSince(status.update_time, now).c_str(),
+                working_set_kb.c_str(), private_kb.c_str());
+}
+
+#ifdef _WIN32
+int ScanPages(bool key_value) {
+    WTS_SESSION_INFOW* sessions = nullptr;
+    DWORD count = 0;
+    if (!WTSEnumerateSessionsW(WTS_CURRENT_SERVER_HANDLE, 0, 1, &sessions, &count)) {
+        std::fprintf(stderr, "mmstat: cannot enumerate sessions\n");
+        return 1;
+    }
+    
+    int found = 0;
+    for (DWORD i = 0; i < count; ++i) {
+        std::wstring name = L"Session\\" + std::to_wstring(sessions[i].SessionId) + L"\\MouseMover-Status";
+        HANDLE mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, name.c_str());
+        if (!mapping) {
+            continue;
+        }
+        auto* page = static_cast<const StatusPage*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(StatusPage)));
+        StatusSnapshot status;
+        if (page && ReadStatusPage(*page, status)) {
+            if (!found++) {
+                PrintHeader(key_value);
+            }
+            PrintPage("session" + std::to_string(sessions[i].SessionId), status, false, key_value);
+        }
+        if (page) {
+            UnmapViewOfFile(page);
+        }
+        CloseHandle(mapping);
+    }
+    WTSFreeMemory(sessions);
+    return found ? 0 : 1;
+}
+#else
+int ScanPages(bool key_value) {
+    DIR* directory = opendir("/dev/shm");
+    if (!directory) {
+        std::fprintf(stderr, "mmstat: cannot read /dev/shm: %s\n", std::strerror(errno));
+        return 1;
+    }
+    
+    const char kPrefix[] = "mm-status-";
+    int found = 0;
+    while (dirent* entry = readdir(directory)) {
+        if (std::strncmp(entry->d_name, kPrefix, sizeof(kPrefix) - 1) != 0) {
+            continue;
+        }
+        int fd = shm_open((std::string("/") + entry->d_name).c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0) {
+            continue;
+        }
+        void* memory = mmap(nullptr, sizeof(StatusPage), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) {
+            continue;
+        }
+        
+        StatusSnapshot status;
+        if (ReadStatusPage(*static_cast<const StatusPage*>(memory), status)) {
+            bool stale = kill(static_cast<pid_t>(status.pid), 0) != 0 && errno == ESRCH;
+            if (!found++) {
+                PrintHeader(key_value);
+            }
+            PrintPage("uid" + std::string(entry->d_name + sizeof(kPrefix) - 1), status, stale, key_value);
+        }
+        munmap(memory, sizeof(StatusPage));
+    }
+    closedir(directory);
+    return found ? 0 : 1;
+}
+#endif
+}
+
+int main(int argc, char** argv) {
+    bool key_value = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--kv") == 0) {
+            key_value = true;
+        } else {
+            std::fprintf(stderr, "usage: mmstat [--kv]\n"
+                                 "  --kv  one line of key=value pairs per instance, times in Unix ms\n");
+            return 2;
+        }
+    }
+    
+    // Exit status 1 when no instance is running
+    return ScanPages(key_value);
+}
@@ -0,0 +1,151 @@
+// Decision trace decoder.
+//
+// Reads a trace written by `mm --trace PATH` (also while mm runs, or after
+// it crashed) or by `mm --ctl trace PATH`, prints one line per decision
+// and a summary. Times are seconds since the first record. "longest
+// unattended gap" is the longest stretch between two moves with no pause
+// or session change in between: it is what to compare with the lock
+// timeout when the machine locked anyway.
+
+#include "trace.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+bool LoadTrace(const char* path, std::vector<TraceRecord>& records, uint64_t& written) {
+    FILE* file = std::fopen(path, "rb");
+    if (!file) {
+        std::fprintf(stderr, "mmtrace: cannot open %s\n", path);
+        return false;
+    }
+    
+    // 64-bit words keep the header and records aligned
+    std::vector<uint64_t> buffer;
+    uint64_t chunk[512];
+    size_t read;
+    while ((read = std::fread(chunk, sizeof(uint64_t), 512, file)) > 0) {
+        buffer.insert(buffer.end(), chunk, chunk + read);
+    }
+    std::fclose(file);
+    
+    const auto* header = reinterpret_cast<const TraceHeader*>(buffer.data());
+    size_t bytes = buffer.size() * sizeof(uint64_t);
+    if (bytes < sizeof(TraceHeader) || header->magic != TraceHeader::kMagic ||
+        bytes < sizeof(TraceHeader) + static_cast<size_t>(header->capacity) * sizeof(TraceRecord)) {
+        std::fprintf(stderr, "mmtrace: %s is not a trace of this version\n", path);
+        return false;
+    }
+    
+    records.resize(header->capacity);
+    records.resize(ReadTrace(*header, reinterpret_cast<const TraceRecord*>(header + 1), records.data(),
+                             records.size()));
+    written = header->head.load(std::memory_order_relaxed);
+    return true;
+}
+
+bool IsMove(const TraceRecord& record) {
+    return record.event == static_cast<uint8_t>(TraceEvent::kMoved) ||
+           record.event == static_cast<uint8_t>(TraceEvent::kNudged);
+}
+
+void PrintRecord(const TraceRecord& record, uint64_t start) {
+    std::printf("%10.3f %-12s cfg=%-4u", (record.time - start) / 1000.0, TraceEventName(record.event),
+                record.config_version);
+    if (record.next) {
+        std::printf(" idle=%.1fs next=+%.1fs", record.idle_ms / 1000.0,
+                    (static_cast<double>(record.next) - static_cast<double>(record.time)) / 1000.0);
+    }
+    if (IsMove(record)) {
+        std::printf(" at %d,%d by %d,%d %s monitor %d,%d-%d,%d", record.x, record.y, record.dx, record.dy,
+                    record.result ? "ok" : "FAILED", record.bounds[0], record.bounds[1], record.bounds[2],
+                    record.bounds[3]);
+    }
+    std::printf("\n");
+}
+
+void PrintSummary(const std::vector<TraceRecord>& records, uint64_t written) {
+    uint64_t counts[static_cast<int>(TraceEvent::kCount)] = {};
+    uint64_t failed = 0;
+    uint64_t longest_gap = 0;
+    uint64_t longest_gap_end = 0;
+    const TraceRecord* previous_move = nullptr;
+    for (const TraceRecord& record : records) {
+        if (record.event < static_cast<uint8_t>(TraceEvent::kCount)) {
+            ++counts[record.event];
+        }
+        if (IsMove(record)) {
+            failed += !record.result;
+            if (previous_move && record.time - previous_move->time > longest_gap) {
+                longest_gap = record.time - previous_move->time;
+                longest_gap_end = record.time;
+            }
+            previous_move = &record;
+        } else if (record.event == static_cast<uint8_t>(TraceEvent::kPaused) ||
+                   record.event == static_cast<uint8_t>(TraceEvent::kAway)) {
+            previous_move = nullptr;
+        }
+    }
+    
+    uint64_t start = records.front().time;
+    std::printf("\n%zu records over %.1f s", records.size(), (records.back().time - start) / 1000.0);
+    if (written > records.size()) {
+        std::printf(" (%llu older ones overwritten or torn)", (unsigned long long)(written - records.size()));
+    }
+    std::printf("\n");
+    for (int event = 0; event < static_cast<int>(TraceEvent::kCount); ++event) {
+        if (counts[event]) {
+            std::printf("  %-12s %llu\n", TraceEventName(static_cast<uint8_t>(event)), (unsigned long long)counts[event]);
+        }
+    }
+    std::printf("  failed moves %llu\n", (unsigned long long)failed);
+    if (longest_gap) {
+        std::printf("  longest unattended gap %.1f s, ending at %.3f\n", longest_gap / 1000.0,
+                    (longest_gap_end - start) / 1000.0);
+    }
+}
+}
+
+int main(int argc, char** argv) {
+    bool summary_only = false;
+    size_t tail = 0;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--summary") == 0) {
+            summary_only = true;
+        } else if (std::strcmp(argv[i], "--tail") == 0 && i + 1 < argc) {
+            tail = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!path && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (!path) {
+        std::fprintf(stderr, "usage: mmtrace [--summary] [--tail N] FILE\n"
+                             "  --summary  only the summary\n"
+                             "  --tail N   only the last N records, then the summary\n");
+        return 2;
+    }
+    
+    std::vector<TraceRecord> records;
+    uint64_t written = 0;
+    if (!LoadTrace(path, records, written)) {
+        return 1;
+    }
+    if (records.empty()) {
+        std::printf("no records\n");
+        return 0;
+    }
+    
+    if (!summary_only) {
+        size_t first = tail && tail < records.size() ? records.size() - tail : 0;
+        for (size_t i = first; i < records.size(); ++i) {
+            PrintRecord(records[i], records.front().time);
+        }
+    }
+    PrintSummary(records, written);
+    return 0;
+}
@@ -0,0 +1,157 @@
+// Wakeup benchmark for timer slack.
+//
+// Replays hours of operation on a virtual clock through the real
+// MouseEngine and TimerWheel on the simulated desktop of simulation.h,
+// with the user alternating between typing and being away. The OS is
+// modelled as Reactor arms it: each wait may complete anywhere inside
+// [expiry - window, expiry], and the kernel completes it early when some
+// other wakeup already happens in that window. Other system activity is a
+// Poisson stream of wakeups.
+//
+// Reports, per slack setting, how many wakeups per hour the mover causes on
+// its own versus how many ride along with wakeups that happen anyway.
+
+#include "config.h"
+#include "config_store.h"
+#include "mouse_engine.h"
+#include "reactor.h"
+#include "simulation.h"
+#include "stats.h"
+#include "timer_wheel.h"
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace {
+constexpr uint64_t kHourMs = 3600000;
+constexpr uint64_t kStatsRefreshMs = 60000;   // same cadence as the tray tooltip refresh
+constexpr int kSlackSettings[] = {0, 5, 10, 25, 50};
+
+struct Result {
+    uint64_t wakeups = 0;       // every timer completion
+    uint64_t own_wakeups = 0;   // completions no other wakeup covered
+    uint64_t moves = 0;
+    uint64_t max_early_ms = 0;
+};
+
+struct Simulation {
+    MouseEngine* engine;
+    TimerWheel* wheel;
+    TimerWheel::Timer* mouse_timer;
+    TimerWheel::Timer* stats_timer;
+    uint64_t fired_at;
+};
+
+void OnMouseTimer(void* context) {
+    auto* sim = static_cast<Simulation*>(context);
+    uint64_t due = sim->mouse_timer->Expiry();
+    uint64_t next = sim->engine->Tick(sim->fired_at, due > sim->fired_at ? due - sim->fired_at : 0);
+    sim->wheel->Schedule(*sim->mouse_timer, next);
+}
+
+void OnStatsTimer(void* context) {
+    auto* sim = static_cast<Simulation*>(context);
+    sim->wheel->Schedule(*sim->stats_timer, sim->fired_at + kStatsRefreshMs);
+}
+
+Result Run(const Config& config, int slack_percent, uint64_t hours, uint64_t ambient_mean_ms,
+           const ActivityTrace& activity, uint64_t idle_timeout_ms) {
+    VirtualClock clock;
+    SimulatedInputBackend backend(clock, activity, idle_timeout_ms);
+    Stats stats;
+    ConfigStore store;
+    store.Publish(config);
+    MouseEngine engine(store, backend, clock, stats);
+    TimerWheel wheel(0);
+    
+    Simulation sim = {&engine, &wheel, nullptr, nullptr, 0};
+    TimerWheel::Timer mouse_timer(&OnMouseTimer, &sim);
+    TimerWheel::Timer stats_timer(&OnStatsTimer, &sim);
+    sim.mouse_timer = &mouse_timer;
+    sim.stats_timer = &stats_timer;
+    wheel.Schedule(mouse_timer, 0);
+    wheel.Schedule(stats_timer, kStatsRefreshMs);
+    
+    // Same seed for every setting so they see identical background activity
+    std::mt19937_64 random(42);
+    std::exponential_distribution<double> gap(1.0 / static_cast<double>(ambient_mean_ms));
+    uint64_t ambient = static_cast<uint64_t>(gap(random));
+    
+    Result result;
+    uint64_t end = hours * kHourMs;
+    while (clock.Now() < end) {
+        uint64_t expiry = wheel.NextExpiry();
+        uint64_t window = Reactor::SlackWindow(clock.Now(), expiry, slack_percent);
+        uint64_t window_start = expiry - window;
+        
+        while (ambient < window_start) {
+            ambient += 1 + static_cast<uint64_t>(gap(random));
+        }
+        
+        uint64_t fired = expiry;
+        if (window && ambient <= expiry) {
+            fired = ambient;
+        } else {
+            ++result.own_wakeups;
+        }
+        ++result.wakeups;
+        if (expiry - fired > result.max_early_ms) {
+            result.max_early_ms = expiry - fired;
+        }
+        
+        clock.Set(fired);
+        sim.fired_at = fired;
+        wheel.Advance(expiry > fired ? expiry : fired);
+    }
+    
+    result.moves = stats.inject_calls.load();
+    return result;
+}
+}
+
+int main(int argc, char** argv) {
+    // Mover options as for mm itself, plus the simulation parameters
+    uint64_t hours = 24;
+    uint64_t ambient_mean_ms = 250;
+    uint64_t user_phase_ms = 20 * 60000;
+    uint64_t idle_timeout_ms = 15 * 60000;
+    
+    std::string mover_args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--hours" && i + 1 < argc) {
+            hours = std::stoull(argv[++i]);
+        } else if (arg == "--ambient-ms" && i + 1 < argc) {
+            ambient_mean_ms = std::stoull(argv[++i]);
+        } else if (arg == "--user-phase-min" && i + 1 < argc) {
+            user_phase_ms = std::stoull(argv[++i]) * 60000;
+        } else if (arg == "--idle-timeout-min" && i + 1 < argc) {
+            idle_timeout_ms = std::stoull(argv[++i]) * 60000;
+        } else {
+            mover_args += arg + ' ';
+        }
+    }
+    
+    Config config;
+    std::string error;
+    if (ParseCommandLine(mover_args, config, error) != ParseResult::kOk || !ValidateConfig(config, error)) {
+        std::fprintf(stderr, "wakeup_bench: %s\n", error.empty() ? "see mm --help for mover options" : error.c_str());
+        return 1;
+    }
+    
+    std::printf("short_delay=%ds long_delay=%ds hours=%llu ambient_mean=%llums user_phase=%llumin\n\n",
+                config.short_delay, config.long_delay, (unsigned long long)hours,
+                (unsigned long long)ambient_mean_ms, (unsigned long long)(user_phase_ms / 60000));
+    std::printf("%6s %12s %12s %10s %14s\n", "slack%", "wakeups/h", "own/h", "moves/h", "max_early_ms");
+    
+    ActivityTrace activity = ActivityTrace::Alternating(user_phase_ms, hours * kHourMs);
+    for (int slack : kSlackSettings) {
+        Result result = Run(config, slack, hours, ambient_mean_ms, activity, idle_timeout_ms);
+        std::printf("%6d %12llu %12llu %10llu %14llu\n", slack,
+                    (unsigned long long)(result.wakeups / hours),
+                    (unsigned long long)(result.own_wakeups / hours),
+                    (unsigned long long)(result.moves / hours),
+                    (unsigned long long)result.max_early_ms);
+    }
+    return 0;
+}